@@ -0,0 +1,342 @@
+/* buffer_cache.c: Cache of file system disk sectors.
+ *
+ * Inode sectors and the partial sectors at the edges of file data are
+ * kept in a fixed set of BUFFER_CACHE_SIZE sector buffers, replaced with
+ * the clock algorithm.  Writes only mark a buffer dirty; it reaches the
+ * disk when it is replaced, when the kworkerd thread writes dirty
+ * buffers behind every second, and at shutdown.
+ *
+ * Whole data sectors, which the page cache reads and writes a page at a
+ * time, go straight to the disk so they are not cached twice.  They
+ * still look in the buffers first, so every access to a sector sees the
+ * newest data no matter which path last wrote it.
+ *
+ * Metadata sectors written with buffer_cache_write_meta are never dirty
+ * here: their new contents go into the running journal transaction,
+ * which writes them in place when it commits.  Until then a miss on one
+ * of them reads the transaction's copy instead of the disk.
+ *
+ * buffer_lock is not held across disk I/O.  A buffer being read or
+ * written is marked busy, and an uncached access to a sector is recorded
+ * in uncached_ios while it runs; anyone else who wants the same sector
+ * waits on buffer_io_done and looks it up again. */
+
+#include <debug.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/buffer_cache.h"
+#include "filesys/filesys.h"
+#include "filesys/journal.h"
+#include "threads/synch.h"
+
+/* 캐시할 섹터 수 */
+#define BUFFER_CACHE_SIZE 64
+
+/* A cached disk sector. */
+struct buffer {
+	disk_sector_t sector;           /* Sector held. */
+	bool valid;                     /* Holds a sector. */
+	bool dirty;                     /* Newer than the disk. */
+	bool accessed;                  /* Used since the clock last passed. */
+	bool busy;                      /* Being read or written; see above. */
+	uint8_t data[DISK_SECTOR_SIZE];
+};
+
+/* A read or write of a sector that goes around the buffers. */
+struct uncached_io {
+	disk_sector_t sector;
+	struct list_elem elem;          /* Element in uncached_ios. */
+};
+
+static struct buffer buffers[BUFFER_CACHE_SIZE];
+static size_t clock_hand;
+/* Protects the buffers and uncached_ios. */
+static struct lock buffer_lock;
+/* Uncached accesses in progress. */
+static struct list uncached_ios;
+/* Signaled, with buffer_lock, whenever a buffer stops being busy or an
+ * uncached access ends. */
+static struct condition buffer_io_done;
+
+// 통계: 버퍼에서 찾은 접근 / 디스크로 간 접근 / flush로 쓴 섹터
+static long long hit_cnt;
+static long long miss_cnt;
+static long long flush_cnt;
+
+/* Initializes the buffer cache. */
+void
+buffer_cache_init (void) {
+	lock_init (&buffer_lock);
+	list_init (&uncached_ios);
+	cond_init (&buffer_io_done);
+}
+
+/* Returns the buffer holding SECTOR, or NULL.  Caller holds
+ * buffer_lock. */
+static struct buffer *
+buffer_find (disk_sector_t sector) {
+	// 64개뿐이라 차례로 훑음
+	for (size_t i = 0; i < BUFFER_CACHE_SIZE; i++)
+		if (buffers[i].valid && buffers[i].sector == sector)
+			return &buffers[i];
+	return NULL;
+}
+
+/* Returns true if an uncached access to SECTOR is in progress.  Caller
+ * holds buffer_lock. */
+static bool
+uncached_busy (disk_sector_t sector) {
+	for (struct list_elem *e = list_begin (&uncached_ios);
+			e != list_end (&uncached_ios); e = list_next (e))
+		if (list_entry (e, struct uncached_io, elem)->sector == sector)
+			return true;
+	return false;
+}
+
+/* Waits until no disk I/O on SECTOR is in progress, then returns the
+ * buffer holding it, or NULL.  Caller holds buffer_lock, which is
+ * released while waiting. */
+static struct buffer *
+buffer_wait (disk_sector_t sector) {
+	for (;;) {
+		struct buffer *b = buffer_find (sector);
+		if ((b == NULL || !b->busy) && !uncached_busy (sector))
+			return b;
+		cond_wait (&buffer_io_done, &buffer_lock);
+	}
+}
+
+/* Marks B, which is not busy, busy and releases buffer_lock for disk I/O
+ * on it. */
+static void
+buffer_io_begin (struct buffer *b) {
+	ASSERT (!b->busy);
+	b->busy = true;
+	lock_release (&buffer_lock);
+}
+
+/* Reacquires buffer_lock after disk I/O on B and wakes up the threads
+ * waiting for it. */
+static void
+buffer_io_end (struct buffer *b) {
+	lock_acquire (&buffer_lock);
+	b->busy = false;
+	cond_broadcast (&buffer_io_done, &buffer_lock);
+}
+
+/* Records an uncached access IO to SECTOR and releases buffer_lock for
+ * it.  No buffer holds SECTOR. */
+static void
+uncached_begin (struct uncached_io *io, disk_sector_t sector) {
+	io->sector = sector;
+	list_push_back (&uncached_ios, &io->elem);
+	lock_release (&buffer_lock);
+}
+
+/* Reacquires buffer_lock after uncached access IO and wakes up the
+ * threads waiting for it. */
+static void
+uncached_end (struct uncached_io *io) {
+	lock_acquire (&buffer_lock);
+	list_remove (&io->elem);
+	cond_broadcast (&buffer_io_done, &buffer_lock);
+}
+
+/* Writes B, which is not busy, to disk if it is dirty.  Caller holds
+ * buffer_lock, which is released during the write. */
+static bool
+buffer_writeback (struct buffer *b) {
+	if (!b->valid || !b->dirty)
+		return false;
+	// busy인 동안은 아무도 고치지 않으므로 쓰기 전에 지워도 됨
+	b->dirty = false;
+	buffer_io_begin (b);
+	disk_write (filesys_disk, b->sector, b->data);
+	buffer_io_end (b);
+	return true;
+}
+
+/* Frees a buffer with the clock algorithm, writing back what it held,
+ * and returns it.  Busy buffers are passed over; if all of them are
+ * busy, waits for one.  Caller holds buffer_lock, which may be released
+ * for a while. */
+static struct buffer *
+buffer_evict (void) {
+	for (size_t i = 0; ; i++) {
+		if (i == 2 * BUFFER_CACHE_SIZE) {
+			cond_wait (&buffer_io_done, &buffer_lock);
+			i = 0;
+		}
+		struct buffer *b = &buffers[clock_hand];
+		clock_hand = (clock_hand + 1) % BUFFER_CACHE_SIZE;
+		if (b->busy)
+			continue;
+		if (!b->valid)
+			return b;
+		if (b->accessed)
+			b->accessed = false;
+		else {
+			buffer_writeback (b);
+			b->valid = false;
+			return b;
+		}
+	}
+}
+
+/* Returns the buffer for SECTOR, loading it into a free buffer on a
+ * miss.  Reading the disk is skipped if FILL is false because the caller
+ * overwrites the whole sector.  Caller holds buffer_lock, which is
+ * released while waiting for a busy buffer and during disk I/O; the
+ * buffer returned is not busy. */
+static struct buffer *
+buffer_get (disk_sector_t sector, bool fill) {
+	struct buffer *b;
+
+	for (;;) {
+		b = buffer_wait (sector);
+		if (b != NULL) {
+			hit_cnt++;
+			break;
+		}
+		b = buffer_evict ();
+		// 내보내느라 lock을 놓은 사이 누가 같은 섹터를 가져왔으면 b는 빈 채로 두고 다시 찾음
+		if (buffer_find (sector) != NULL || uncached_busy (sector))
+			continue;
+		miss_cnt++;
+		b->sector = sector;
+		b->valid = true;
+		b->dirty = false;
+		// 아직 commit되지 않은 metadata는 디스크보다 저널의 것이 새것
+		if (fill && !journal_read (sector, b->data)) {
+			buffer_io_begin (b);
+			disk_read (filesys_disk, sector, b->data);
+			buffer_io_end (b);
+		}
+		break;
+	}
+	b->accessed = true;
+	return b;
+}
+
+/* Reads SIZE bytes at OFS in SECTOR into BUFFER through the cache. */
+void
+buffer_cache_read (disk_sector_t sector, void *buffer, int ofs, int size) {
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&buffer_lock);
+	memcpy (buffer, buffer_get (sector, true)->data + ofs, size);
+	lock_release (&buffer_lock);
+}
+
+/* Writes SIZE bytes from BUFFER to OFS in SECTOR through the cache.  The
+ * sector is written to disk later. */
+void
+buffer_cache_write (disk_sector_t sector, const void *buffer, int ofs,
+		int size) {
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&buffer_lock);
+	struct buffer *b = buffer_get (sector, size < DISK_SECTOR_SIZE);
+	memcpy (b->data + ofs, buffer, size);
+	b->dirty = true;
+	lock_release (&buffer_lock);
+}
+
+/* Writes SIZE bytes from BUFFER to OFS in metadata SECTOR through the
+ * cache, like buffer_cache_write.  With a journal, the sector goes into
+ * the running transaction instead, and reaches its place on disk when
+ * that commits. */
+void
+buffer_cache_write_meta (disk_sector_t sector, const void *buffer, int ofs,
+		int size) {
+	ASSERT (ofs >= 0 && size >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	if (!journal_enabled ()) {
+		buffer_cache_write (sector, buffer, ofs, size);
+		return;
+	}
+
+	lock_acquire (&buffer_lock);
+	struct buffer *b = buffer_get (sector, size < DISK_SECTOR_SIZE);
+	memcpy (b->data + ofs, buffer, size);
+	// 제자리에는 commit이 씀
+	b->dirty = false;
+	journal_add (sector, b->data);
+	lock_release (&buffer_lock);
+}
+
+/* Reads all of SECTOR into BUFFER, from the cache if it is there and
+ * from disk, without caching it, otherwise. */
+void
+buffer_cache_read_through (disk_sector_t sector, void *buffer) {
+	struct uncached_io io;
+
+	lock_acquire (&buffer_lock);
+	struct buffer *b = buffer_wait (sector);
+	if (b != NULL) {
+		hit_cnt++;
+		memcpy (buffer, b->data, DISK_SECTOR_SIZE);
+	} else if (!journal_read (sector, buffer)) {
+		uncached_begin (&io, sector);
+		disk_read (filesys_disk, sector, buffer);
+		uncached_end (&io);
+	}
+	lock_release (&buffer_lock);
+}
+
+/* Writes all of SECTOR from BUFFER to disk now, updating the cached copy
+ * if there is one. */
+void
+buffer_cache_write_through (disk_sector_t sector, const void *buffer) {
+	struct uncached_io io;
+
+	lock_acquire (&buffer_lock);
+	struct buffer *b = buffer_wait (sector);
+	if (b != NULL) {
+		// 쓰는 동안 깨끗한 버퍼가 쫓겨나 옛 내용이 다시 읽히지 않도록 busy로 둠
+		memcpy (b->data, buffer, DISK_SECTOR_SIZE);
+		b->dirty = false;
+		buffer_io_begin (b);
+		disk_write (filesys_disk, sector, buffer);
+		buffer_io_end (b);
+	} else {
+		uncached_begin (&io, sector);
+		disk_write (filesys_disk, sector, buffer);
+		uncached_end (&io);
+	}
+	lock_release (&buffer_lock);
+}
+
+/* Fills SECTOR with zeros in the cache, without reading it first.  The
+ * sector is written to disk later. */
+void
+buffer_cache_zero (disk_sector_t sector) {
+	lock_acquire (&buffer_lock);
+	struct buffer *b = buffer_get (sector, false);
+	memset (b->data, 0, DISK_SECTOR_SIZE);
+	b->dirty = true;
+	lock_release (&buffer_lock);
+}
+
+/* Writes every dirty buffer to disk, waiting for those that are being
+ * written already. */
+void
+buffer_cache_flush (void) {
+	lock_acquire (&buffer_lock);
+	for (size_t i = 0; i < BUFFER_CACHE_SIZE; i++) {
+		struct buffer *b = &buffers[i];
+		while (b->busy)
+			cond_wait (&buffer_io_done, &buffer_lock);
+		if (buffer_writeback (b))
+			flush_cnt++;
+	}
+	lock_release (&buffer_lock);
+}
+
+/* Prints buffer cache statistics. */
+void
+buffer_cache_print_stats (void) {
+	printf ("Buffer cache: %lld hits, %lld misses, %lld sectors written back\n",
+			hit_cnt, miss_cnt, flush_cnt);
+}
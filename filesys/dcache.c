@@ -0,0 +1,183 @@
+/* dcache.c: Cache of directory lookups.
+ *
+ * Remembers the outcome of recent lookups of a name in a directory,
+ * keyed by the directory's inode sector and the name: the directory
+ * entry found, or that there was none.  Resolving a path then costs a
+ * hash lookup per component instead of a search of each directory.
+ *
+ * At most DCACHE_SIZE names are kept, the least recently used dropped
+ * first.  The directory code keeps the cache up to date: it stores what
+ * it adds, changes or removes, and drops everything cached under a
+ * directory that is removed, whose sector may be reused. */
+
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/dcache.h"
+#include "filesys/directory.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* 캐시할 이름 수 */
+#define DCACHE_SIZE 256
+
+/* A cached lookup. */
+struct dentry {
+	disk_sector_t dir;              /* Inode sector of the directory. */
+	char name[NAME_MAX + 1];        /* Name looked up. */
+	bool found;                     /* False: DIR has no NAME. */
+	struct dir_entry e;             /* Entry, if FOUND. */
+	struct hash_elem elem;          /* Element in dentries. */
+	struct list_elem lru_elem;      /* Element in lru_list. */
+};
+
+static struct hash dentries;
+/* Most recently used first. */
+static struct list lru_list;
+static struct lock dcache_lock;
+
+// 통계: 캐시에서 찾은 조회 / 디렉터리를 뒤진 조회
+static long long hit_cnt;
+static long long miss_cnt;
+
+static uint64_t
+dentry_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct dentry *d = hash_entry (e, struct dentry, elem);
+	return hash_string (d->name) ^ hash_int (d->dir);
+}
+
+static bool
+dentry_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct dentry *a = hash_entry (a_, struct dentry, elem);
+	const struct dentry *b = hash_entry (b_, struct dentry, elem);
+	if (a->dir != b->dir)
+		return a->dir < b->dir;
+	return strcmp (a->name, b->name) < 0;
+}
+
+/* Initializes the directory lookup cache. */
+void
+dcache_init (void) {
+	hash_init (&dentries, dentry_hash, dentry_less, NULL);
+	list_init (&lru_list);
+	lock_init (&dcache_lock);
+}
+
+/* Returns the cached lookup of NAME in DIR, or NULL.  Caller holds
+ * dcache_lock. */
+static struct dentry *
+dentry_find (disk_sector_t dir, const char *name) {
+	struct dentry key;
+	struct hash_elem *e;
+
+	key.dir = dir;
+	strlcpy (key.name, name, sizeof key.name);
+	e = hash_find (&dentries, &key.elem);
+	return e != NULL ? hash_entry (e, struct dentry, elem) : NULL;
+}
+
+/* Forgets D.  Caller holds dcache_lock. */
+static void
+dentry_free (struct dentry *d) {
+	hash_delete (&dentries, &d->elem);
+	list_remove (&d->lru_elem);
+	free (d);
+}
+
+/* Looks NAME up in the directory whose inode is at sector DIR.  Returns
+ * false if it is not cached.  Otherwise returns true and sets *FOUND to
+ * whether DIR has NAME, and if so stores its entry in *EP if EP is
+ * non-null. */
+bool
+dcache_lookup (disk_sector_t dir, const char *name, struct dir_entry *ep,
+		bool *found) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return false;
+
+	lock_acquire (&dcache_lock);
+	d = dentry_find (dir, name);
+	if (d != NULL) {
+		hit_cnt++;
+		list_remove (&d->lru_elem);
+		list_push_front (&lru_list, &d->lru_elem);
+		*found = d->found;
+		if (d->found && ep != NULL)
+			*ep = d->e;
+	} else
+		miss_cnt++;
+	lock_release (&dcache_lock);
+	return d != NULL;
+}
+
+/* Records that DIR's entry for NAME is E, or that DIR has no NAME if E
+ * is null. */
+void
+dcache_insert (disk_sector_t dir, const char *name,
+		const struct dir_entry *e) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+
+	lock_acquire (&dcache_lock);
+	d = dentry_find (dir, name);
+	if (d != NULL)
+		list_remove (&d->lru_elem);
+	else {
+		// 가득 찼으면 가장 오래 안 쓴 이름을 버림
+		if (hash_size (&dentries) >= DCACHE_SIZE)
+			dentry_free (list_entry (list_back (&lru_list), struct dentry,
+						lru_elem));
+		d = malloc (sizeof *d);
+		if (d == NULL) {
+			lock_release (&dcache_lock);
+			return;
+		}
+		d->dir = dir;
+		strlcpy (d->name, name, sizeof d->name);
+		hash_insert (&dentries, &d->elem);
+	}
+	list_push_front (&lru_list, &d->lru_elem);
+	d->found = e != NULL;
+	if (e != NULL)
+		d->e = *e;
+	lock_release (&dcache_lock);
+}
+
+/* Forgets the lookup of NAME in DIR. */
+void
+dcache_invalidate (disk_sector_t dir, const char *name) {
+	struct dentry *d;
+
+	lock_acquire (&dcache_lock);
+	d = dentry_find (dir, name);
+	if (d != NULL)
+		dentry_free (d);
+	lock_release (&dcache_lock);
+}
+
+/* Forgets every lookup in DIR, which is being removed. */
+void
+dcache_purge_dir (disk_sector_t dir) {
+	struct list_elem *e, *next;
+
+	lock_acquire (&dcache_lock);
+	for (e = list_begin (&lru_list); e != list_end (&lru_list); e = next) {
+		struct dentry *d = list_entry (e, struct dentry, lru_elem);
+		next = list_next (e);
+		if (d->dir == dir)
+			dentry_free (d);
+	}
+	lock_release (&dcache_lock);
+}
+
+/* Prints directory lookup cache statistics. */
+void
+dcache_print_stats (void) {
+	printf ("Dentry cache: %lld hits, %lld misses\n", hit_cnt, miss_cnt);
+}
@@ -1,11 +1,17 @@
 #include "filesys/directory.h"
+#include <hash.h>
 #include <stdio.h>
 #include <string.h>
 #include <list.h>
+#include <round.h>
+#include "filesys/buffer_cache.h"
+#include "filesys/dcache.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 
 #include "filesys/fat.h"
 
@@ -28,6 +34,180 @@
 // 	bool in_use;                        /* In use or free? */
 // };
 
+/* A directory is an array of entries.  Small directories are searched
+ * from the start, and a new entry goes into the first free slot or at
+ * the end.  Once a directory would grow past DIR_LINEAR_MAX slots it is
+ * turned into an open-addressing hash table instead: an entry lives in
+ * the slot its name hashes to, or in one of the slots after it, so a
+ * lookup reads only a slot or two however large the directory is.
+ *
+ * A hashed directory has a power-of-2 number of slots.  A slot that has
+ * never been used (an empty name) ends a search; a removed entry keeps
+ * its name so that searches go on past it, and its slot is reused by
+ * the next entry added there.  When more than 3/4 of the slots have been
+ * used the table is rebuilt with twice as many slots as live entries, up
+ * to DIR_HASHED_MAX.  The new table is built in memory, written to new
+ * clusters and then put in place of the old one, in a single journal
+ * operation whatever the size of the directory. */
+
+/* Most slots a linearly searched directory has. */
+#define DIR_LINEAR_MAX 128
+
+/* Fewest slots a hashed directory has. */
+#define DIR_HASHED_MIN 256
+
+/* Most slots a hashed directory has, so that the FAT sectors of a new
+ * table fit in one journal operation (include/filesys/journal.h).  A
+ * directory holds up to 3/4 as many entries. */
+#define DIR_HASHED_MAX 16384
+
+/* Returns the number of entry slots in DIR. */
+static size_t
+dir_slots (const struct dir *dir) {
+	return inode_length (dir->inode) / sizeof (struct dir_entry);
+}
+
+/* Returns true if the unused entry E was never used, which ends a search
+ * in a hashed directory, rather than removed. */
+static bool
+entry_empty (const struct dir_entry *e) {
+	return e->name[0] == '\0';
+}
+
+/* Searches hashed DIR for NAME.  If found, returns true and stores the
+ * entry in *EP and its offset in *OFSP, if they are non-null.
+ * Otherwise returns false and stores the offset of the slot a new entry
+ * for NAME should go in in *FREEP, if non-null, or -1 if every slot is in
+ * use. */
+static bool
+hashed_lookup (const struct dir *dir, const char *name,
+		struct dir_entry *ep, off_t *ofsp, off_t *freep) {
+	size_t slots = dir_slots (dir);
+	size_t i = hash_string (name) & (slots - 1);
+	off_t free_ofs = -1;
+	struct dir_entry e;
+
+	for (size_t n = 0; n < slots; n++, i = (i + 1) & (slots - 1)) {
+		off_t ofs = i * sizeof e;
+		if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+			break;
+		if (e.in_use) {
+			if (!strcmp (name, e.name)) {
+				if (ep != NULL)
+					*ep = e;
+				if (ofsp != NULL)
+					*ofsp = ofs;
+				return true;
+			}
+			continue;
+		}
+		// 지워진 칸은 새 엔트리 자리로 기억해 두고 계속 찾음
+		if (free_ofs == -1)
+			free_ofs = ofs;
+		if (entry_empty (&e))
+			break;
+	}
+	if (freep != NULL)
+		*freep = free_ofs;
+	return false;
+}
+
+/* Copies the entry E into slot SLOT of TABLE, the image of a hashed
+ * directory being built a page at a time, or out of it if !STORE.  An
+ * entry may straddle two pages. */
+static void
+table_copy (uint8_t **table, size_t slot, struct dir_entry *e, bool store) {
+	size_t ofs = slot * sizeof *e;
+	uint8_t *p = (uint8_t *) e;
+
+	for (size_t left = sizeof *e; left > 0; ) {
+		size_t page_ofs = ofs % PGSIZE;
+		size_t chunk = PGSIZE - page_ofs < left ? PGSIZE - page_ofs : left;
+		uint8_t *q = table[ofs / PGSIZE] + page_ofs;
+		if (store)
+			memcpy (q, p, chunk);
+		else
+			memcpy (p, q, chunk);
+		ofs += chunk;
+		p += chunk;
+		left -= chunk;
+	}
+}
+
+/* Rebuilds DIR, which holds LIVE entries, as a hashed directory with
+ * room for twice as many, or DIR_HASHED_MAX slots at most.  The new
+ * table is built in memory from the live entries, written to a run of
+ * new clusters and only then made DIR's data, so that a crash leaves
+ * either table whole and the journal operation records only the switch.
+ * Returns false if memory or disk space runs out, or the table would be
+ * too full even at its largest, leaving DIR as it was. */
+static bool
+dir_rehash (struct dir *dir, size_t live) {
+	size_t old_slots = dir_slots (dir);
+	size_t slots = DIR_HASHED_MIN;
+	size_t page_cnt, sectors;
+	uint8_t **table;
+	struct dir_entry e, t;
+	size_t cnt = 0, i;
+	bool success = false;
+
+	while (slots < live * 2 && slots < DIR_HASHED_MAX)
+		slots *= 2;
+	if (live * 4 > slots * 3)
+		return false;
+	page_cnt = DIV_ROUND_UP (slots * sizeof e, PGSIZE);
+	sectors = DIV_ROUND_UP (slots * sizeof e, DISK_SECTOR_SIZE);
+
+	table = calloc (page_cnt, sizeof *table);
+	if (table == NULL)
+		return false;
+	for (i = 0; i < page_cnt; i++)
+		if ((table[i] = palloc_get_page (PAL_ZERO)) == NULL)
+			goto done;
+
+	/* Place the live entries by hash.  The table starts out with every
+	 * slot empty, so each goes in the first empty slot from its own. */
+	for (i = 0; i < old_slots && cnt < live; i++) {
+		if (inode_read_at (dir->inode, &e, sizeof e, i * sizeof e) != sizeof e)
+			goto done;
+		if (!e.in_use)
+			continue;
+		size_t slot = hash_string (e.name) & (slots - 1);
+		for (;;) {
+			table_copy (table, slot, &t, false);
+			if (entry_empty (&t))
+				break;
+			slot = (slot + 1) & (slots - 1);
+		}
+		table_copy (table, slot, &e, true);
+		cnt++;
+	}
+
+	/* Write the table to new clusters, then switch DIR to them.  The
+	 * writes go straight to disk, ahead of the commit of the switch. */
+	cluster_t first = fat_create_run (sectors);
+	if (first == 0)
+		goto done;
+	for (i = 0; i < sectors; i++)
+		buffer_cache_write_through (cluster_to_sector (first + i),
+				table[i / (PGSIZE / DISK_SECTOR_SIZE)]
+				+ i % (PGSIZE / DISK_SECTOR_SIZE) * DISK_SECTOR_SIZE);
+	if (!inode_replace_data (dir->inode, cluster_to_sector (first), sectors,
+				slots * sizeof e)) {
+		fat_remove_chain (first, 0);
+		goto done;
+	}
+	inode_set_dir_index (dir->inode, true, cnt);
+	success = true;
+
+done:
+	for (i = 0; i < page_cnt; i++)
+		if (table[i] != NULL)
+			palloc_free_page (table[i]);
+	free (table);
+	return success;
+}
+
 //Project 4-2
 // find current working directory
 struct dir *current_directory(){
@@ -132,13 +312,13 @@ dir_get_inode (struct dir *dir) {
 	return dir->inode;
 }
 
-/* Searches DIR for a file with the given NAME.
+/* Searches DIR's entries for a file with the given NAME.
  * If successful, returns true, sets *EP to the directory entry
  * if EP is non-null, and sets *OFSP to the byte offset of the
  * directory entry if OFSP is non-null.
  * otherwise, returns false and ignores EP and OFSP. */
-bool
-lookup (const struct dir *dir, const char *name,
+static bool
+dir_search (const struct dir *dir, const char *name,
 		struct dir_entry *ep, off_t *ofsp) {
 	struct dir_entry e;
 	size_t ofs;
@@ -146,6 +326,9 @@ lookup (const struct dir *dir, const char *name,
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	if (inode_dir_hashed (dir->inode))
+		return hashed_lookup (dir, name, ep, ofsp, NULL);
+
 	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 			ofs += sizeof e)
 		if (e.in_use && !strcmp (name, e.name)) {
@@ -158,6 +341,46 @@ lookup (const struct dir *dir, const char *name,
 	return false;
 }
 
+/* Searches DIR for NAME like dir_search() and records the outcome in
+ * the dentry cache.  Caller holds DIR's dir_lock, which every change to
+ * DIR's entries also holds from the write until the cache is updated,
+ * so what is recorded cannot be out of date already. */
+static bool
+lookup_fill (const struct dir *dir, const char *name,
+		struct dir_entry *ep, off_t *ofsp) {
+	struct dir_entry e;
+	bool found;
+
+	ASSERT (lock_held_by_current_thread (&dir->inode->dir_lock));
+
+	found = dir_search (dir, name, &e, ofsp);
+	dcache_insert (inode_get_inumber (dir->inode), name, found ? &e : NULL);
+	if (found && ep != NULL)
+		*ep = e;
+	return found;
+}
+
+/* Searches DIR for a file with the given NAME.
+ * If successful, returns true, sets *EP to the directory entry
+ * if EP is non-null, and sets *OFSP to the byte offset of the
+ * directory entry if OFSP is non-null.
+ * otherwise, returns false and ignores EP and OFSP.
+ * Answers from the dentry cache unless the caller needs the offset. */
+bool
+lookup (const struct dir *dir, const char *name,
+		struct dir_entry *ep, off_t *ofsp) {
+	bool found;
+
+	if (ofsp == NULL && dcache_lookup (inode_get_inumber (dir->inode), name,
+				ep, &found))
+		return found;
+
+	lock_acquire (&dir->inode->dir_lock);
+	found = lookup_fill (dir, name, ep, ofsp);
+	lock_release (&dir->inode->dir_lock);
+	return found;
+}
+
 /* Searches DIR for a file with the given NAME
  * and returns true if one exists, false otherwise.
  * On success, sets *INODE to an inode for the file, otherwise to
@@ -188,27 +411,40 @@ dir_lookup (const struct dir *dir, const char *name,
 	return *inode != NULL;
 }
 
-/* Adds a file named NAME to DIR, which must not already contain a
- * file by that name.  The file's inode is in sector
- * INODE_SECTOR.
- * Returns true if successful, false on failure.
- * Fails if NAME is invalid (i.e. too long) or a disk or memory
- * error occurs. */
-bool
-dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
+/* Does dir_add() for a caller that holds DIR's dir_lock. */
+static bool
+dir_add_locked (struct dir *dir, const char *name,
+		disk_sector_t inode_sector) {
 	struct dir_entry e;
 	off_t ofs;
 	bool success = false;
 
-	ASSERT (dir != NULL);
-	ASSERT (name != NULL);
-
-	/* Check NAME for validity. */
-	if (*name == '\0' || strlen (name) > NAME_MAX) // #ifdef DBG file name limit - optional to keep or change
-		return false;
+	if (inode_dir_hashed (dir->inode)) {
+		/* Find NAME's slot, rebuilding the table first if it is getting
+		 * full. */
+		size_t used = inode_dir_used (dir->inode);
+		if ((used + 1) * 4 > dir_slots (dir) * 3) {
+			size_t live = 0;
+			for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+					ofs += sizeof e)
+				live += e.in_use;
+			// 더 키울 수 없어도 한 번도 안 쓴 칸이 남아 있으면 그대로 넣음
+			if (dir_rehash (dir, live + 1))
+				used = inode_dir_used (dir->inode);
+			else if (used + 1 >= dir_slots (dir))
+				goto done;
+		}
+		if (hashed_lookup (dir, name, NULL, NULL, &ofs) || ofs == -1)
+			goto done;
+		if (inode_read_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
+			goto done;
+		if (entry_empty (&e))
+			inode_set_dir_index (dir->inode, true, used + 1);
+		goto write;
+	}
 
 	/* Check that NAME is not in use. */
-	if (lookup (dir, name, NULL, NULL))
+	if (lookup_fill (dir, name, NULL, NULL))
 		goto done;
 
 	/* Set OFS to offset of free slot.
@@ -225,6 +461,15 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 		if (!e.in_use)
 			break;
 
+	/* A full directory that has grown large turns into a hashed one, and
+	 * NAME is then added to that. */
+	if ((size_t) ofs / sizeof e >= DIR_LINEAR_MAX) {
+		if (!dir_rehash (dir, ofs / sizeof e + 1))
+			goto done;
+		return dir_add_locked (dir, name, inode_sector);
+	}
+
+write:
 	/* Write slot. */
 	e.in_use = true;
 	e.is_sym = false;
@@ -232,11 +477,37 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	strlcpy (e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
 	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	if (success)
+		dcache_insert (inode_get_inumber (dir->inode), name, &e);
 
 done:
 	return success;
 }
 
+/* Adds a file named NAME to DIR, which must not already contain a
+ * file by that name.  The file's inode is in sector
+ * INODE_SECTOR.
+ * Returns true if successful, false on failure.
+ * Fails if NAME is invalid (i.e. too long) or a disk or memory
+ * error occurs. */
+bool
+dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
+	bool success;
+
+	ASSERT (dir != NULL);
+	ASSERT (name != NULL);
+
+	/* Check NAME for validity. */
+	if (*name == '\0' || strlen (name) > NAME_MAX) // #ifdef DBG file name limit - optional to keep or change
+		return false;
+
+	// 찾아서 쓰는 동안 다른 스레드가 옛 내용을 dentry cache에 넣지 못하게 함
+	lock_acquire (&dir->inode->dir_lock);
+	success = dir_add_locked (dir, name, inode_sector);
+	lock_release (&dir->inode->dir_lock);
+	return success;
+}
+
 /* Removes any entry for NAME in DIR.
  * Returns true if successful, false on failure,
  * which occurs only if there is no file with the given NAME. */
@@ -250,14 +521,20 @@ dir_remove (struct dir *dir, const char *name) {
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
+	// 디스크의 entry를 지운 뒤 dentry cache에서 뺄 때까지 채우는 쪽을 막음
+	lock_acquire (&dir->inode->dir_lock);
+
 	/* Find directory entry. */
-	if (!lookup (dir, name, &e, &ofs))
+	if (!lookup_fill (dir, name, &e, &ofs))
 		goto done;
 
 	//project 4-2 : remove symlink
 	if (e.is_sym){
 		e.in_use = false;
-		return (inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e);
+		success = inode_write_at(dir->inode, &e, sizeof e, ofs) == sizeof e;
+		if (success)
+			dcache_invalidate (inode_get_inumber (dir->inode), name);
+		goto done;
 	}
 
 	/* Open inode. */
@@ -281,12 +558,17 @@ dir_remove (struct dir *dir, const char *name) {
 	e.in_use = false;
 	if (inode_write_at (dir->inode, &e, sizeof e, ofs) != sizeof e)
 		goto done;
+	dcache_invalidate (inode_get_inumber (dir->inode), name);
+	// 지운 디렉터리의 sector는 다른 디렉터리가 다시 쓸 수 있음
+	if (inode_isdir (inode))
+		dcache_purge_dir (e.inode_sector);
 
 	/* Remove inode. */
 	inode_remove (inode);
 	success = true;
 
 done:
+	lock_release (&dir->inode->dir_lock);
 	inode_close (inode);
 	return success;
 }
@@ -312,23 +594,24 @@ dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 void set_entry_symlink(struct dir* dir, const char *name, bool issym){
 	struct dir_entry e;
 	off_t ofs;
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e; ofs += sizeof e){
-		if (e.in_use && !strcmp (name, e.name)){
-			break;
-		}
+	lock_acquire (&dir->inode->dir_lock);
+	if (lookup_fill (dir, name, &e, &ofs)) {
+		e.is_sym = issym;
+		// 디스크에 쓴 다음에야 cache에 넣음
+		if (inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e)
+			dcache_insert (inode_get_inumber (dir->inode), name, &e);
 	}
-	e.is_sym = issym;
-	inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	lock_release (&dir->inode->dir_lock);
 }
 // set dir entry's lazy symlink target info
 void set_entry_lazytar(struct dir* dir, const char *name, const char *tar){
 	struct dir_entry e;
 	off_t ofs;
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e; ofs += sizeof e){
-		if (e.in_use && !strcmp (name, e.name)){
-			break;
-		}
+	lock_acquire (&dir->inode->dir_lock);
+	if (lookup_fill (dir, name, &e, &ofs)) {
+		strlcpy(e.lazy, tar, sizeof e.lazy);
+		if (inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e)
+			dcache_insert (inode_get_inumber (dir->inode), name, &e);
 	}
-	strlcpy(e.lazy, tar, sizeof e.lazy);
-	inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	lock_release (&dir->inode->dir_lock);
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "filesys/fat.h"
+#include <round.h>
 #include "devices/disk.h"
+#include "filesys/buffer_cache.h"
 #include "filesys/filesys.h"
+#include "filesys/journal.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
 #include <stdio.h>
@@ -16,6 +19,11 @@ struct fat_boot {
 	unsigned int fat_start; // start sector in disk to store FAT (fat_open, fat_close)
 	unsigned int fat_sectors; /* Size of FAT in sectors. */
 	unsigned int root_dir_cluster;
+	unsigned int bitmap_start; /* Free cluster bitmap, after the FAT. */
+	unsigned int bitmap_sectors; /* Size of the bitmap in sectors, or 0. */
+	unsigned int clean; /* FAT and bitmap were closed by fat_close. */
+	unsigned int journal_start; /* Metadata journal, after the bitmap. */
+	unsigned int journal_sectors; /* Size of the journal in sectors, or 0. */
 };
 
 /* FAT FS */
@@ -24,10 +32,35 @@ struct fat_fs {
 	unsigned int *fat; // FAT
 	unsigned int fat_length; // how many clusters in the filesystem
 	disk_sector_t data_start; // in which sector we can start to store files
-	cluster_t last_clst;
-	struct lock write_lock;
+	cluster_t last_clst; // next-fit cursor: 새 extent는 여기부터 찾음
+	struct lock write_lock; // FAT 할당/해제 보호
+	struct lock load_lock; // FAT sector를 읽어 들이는 동안 잡음
+	struct bitmap *loaded; // FAT sectors read in from disk
+	struct bitmap *dirty; // FAT sectors changed since written
+	struct bitmap *bitmap_dirty; // Bitmap sectors changed since written
+	struct bitmap *freed; // Clusters freed since the FAT was last flushed
+	struct bitmap *freeing; // Freed clusters, reusable once committed
+	struct bitmap *written; // Unwritten clusters written since fat_sync_written
 };
 
+/* FAT entries per FAT sector. */
+#define FAT_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
+/* Bits of the free cluster bitmap per sector. */
+#define BITS_PER_SECTOR (DISK_SECTOR_SIZE * 8)
+
+/* Free clusters in a row that a chain starting a new extent looks for.
+ * The next-fit cursor moves past the whole run, so a file growing at the
+ * same time as another keeps the rest of the run to grow into instead of
+ * interleaving its clusters with the other file's. */
+#define FAT_RUN 8
+
+/* Set in a cluster's own FAT entry, next to the link to the following
+ * cluster, while the cluster holds no data yet: it belongs to a file
+ * but has never been written, and reads as zeros without touching the
+ * disk.  Cluster numbers never reach this bit. */
+#define FAT_UNWRITTEN 0x80000000
+
 static struct fat_fs *fat_fs;
 
 void fat_boot_create (void);
@@ -35,12 +68,84 @@ void fat_fs_init (void);
 
 struct bitmap * fat_bitmap;
 
-cluster_t get_empty_cluster () {
-	size_t clst = bitmap_scan_and_flip(fat_bitmap, 0, 1, false) + 1; // index starts with 0, but cluster starts with 1
-	if (clst == BITMAP_ERROR)  
-		return 0;
-	else
-		return (cluster_t) clst;
+static long long alloc_cnt;         /* Clusters allocated. */
+static long long contig_cnt;        /* ...right after the previous one. */
+static long long load_cnt;          /* FAT sectors read. */
+static long long sync_cnt;          /* FAT and bitmap sectors written. */
+
+static void remove_chain (cluster_t clst, cluster_t pclst);
+
+/* Returns the FAT entry of CLST, reading its FAT sector in from disk the
+ * first time it is needed.  The FAT is read in piece by piece like this
+ * so that mounting does not read all of it. */
+static unsigned int *
+fat_entry (cluster_t clst) {
+	size_t sec = (clst - 1) / FAT_PER_SECTOR;
+
+	ASSERT(clst >= 1 && clst <= fat_fs->fat_length);
+	if (!bitmap_test (fat_fs->loaded, sec)) {
+		lock_acquire (&fat_fs->load_lock);
+		if (!bitmap_test (fat_fs->loaded, sec)) {
+			disk_read (filesys_disk, fat_fs->bs.fat_start + sec,
+					fat_fs->fat + sec * FAT_PER_SECTOR);
+			load_cnt++;
+			bitmap_mark (fat_fs->loaded, sec);
+		}
+		lock_release (&fat_fs->load_lock);
+	}
+	return &fat_fs->fat[clst - 1];
+}
+
+/* Sets the FAT entry of CLST to VAL and marks its FAT sector dirty. */
+static void
+fat_set (cluster_t clst, unsigned int val) {
+	*fat_entry (clst) = val;
+	bitmap_mark (fat_fs->dirty, (clst - 1) / FAT_PER_SECTOR);
+}
+
+/* Marks cluster IDX + 1 used or free in fat_bitmap, and the bitmap
+ * sector that holds it dirty. */
+static void
+fat_bitmap_set (size_t idx, bool used) {
+	bitmap_set (fat_bitmap, idx, used);
+	bitmap_mark (fat_fs->bitmap_dirty, idx / BITS_PER_SECTOR);
+}
+
+/* Takes a free cluster to follow PREV in a chain, or to start a chain if
+ * PREV is 0, and returns it, or 0 if the disk is full.
+ * The cluster right after PREV is preferred; otherwise the search goes
+ * on from the next-fit cursor, for a run of FAT_RUN free clusters first
+ * and then for any free cluster.  Caller holds write_lock. */
+static cluster_t
+get_empty_cluster (cluster_t prev) {
+	size_t cnt = bitmap_size (fat_bitmap);
+	size_t cursor = fat_fs->last_clst < cnt ? fat_fs->last_clst : 0;
+	size_t idx;
+
+	// index starts with 0, but cluster starts with 1
+	if (prev != 0 && prev < cnt && !bitmap_test (fat_bitmap, prev)) {
+		fat_bitmap_set (prev, true);
+		contig_cnt++;
+		alloc_cnt++;
+		return prev + 1;
+	}
+
+	idx = bitmap_scan (fat_bitmap, cursor, FAT_RUN, false);
+	if (idx == BITMAP_ERROR)
+		idx = bitmap_scan (fat_bitmap, 0, FAT_RUN, false);
+	if (idx != BITMAP_ERROR)
+		fat_fs->last_clst = idx + FAT_RUN;
+	else {
+		idx = bitmap_scan (fat_bitmap, cursor, 1, false);
+		if (idx == BITMAP_ERROR)
+			idx = bitmap_scan (fat_bitmap, 0, 1, false);
+		if (idx == BITMAP_ERROR)
+			return 0;
+		fat_fs->last_clst = idx + 1;
+	}
+	fat_bitmap_set (idx, true);
+	alloc_cnt++;
+	return idx + 1;
 }
 
 
@@ -63,7 +168,20 @@ fat_init (void) {
 		fat_boot_create ();
 	fat_fs_init ();
 
+	lock_init (&fat_fs->write_lock);
+	lock_init (&fat_fs->load_lock);
 	fat_bitmap = bitmap_create(fat_fs->fat_length); // #ifdef DBG Q. 0번째는 ROOT_DIR_CLUSTER니까 1로 채워넣어야 하지 않을까?
+	fat_fs->loaded = bitmap_create (fat_fs->bs.fat_sectors);
+	fat_fs->dirty = bitmap_create (fat_fs->bs.fat_sectors);
+	fat_fs->bitmap_dirty = bitmap_create (DIV_ROUND_UP (fat_fs->fat_length,
+				BITS_PER_SECTOR));
+	fat_fs->freed = bitmap_create (fat_fs->fat_length);
+	fat_fs->freeing = bitmap_create (fat_fs->fat_length);
+	fat_fs->written = bitmap_create (fat_fs->fat_length);
+	if (fat_bitmap == NULL || fat_fs->loaded == NULL || fat_fs->dirty == NULL
+			|| fat_fs->bitmap_dirty == NULL || fat_fs->freed == NULL
+			|| fat_fs->freeing == NULL || fat_fs->written == NULL)
+		PANIC ("FAT init failed");
 	#ifdef DBG_FAT
 	printf("(fat_create) fat len : %d, sector of last FAT entry : %d\n", fat_fs->fat_length, cluster_to_sector(fat_fs->fat_length));
 	#endif
@@ -72,73 +190,161 @@ fat_init (void) {
 	#endif
 }
 
+/* Writes the boot sector. */
+static void
+write_boot (void) {
+	uint8_t *bounce = calloc (1, DISK_SECTOR_SIZE);
+	if (bounce == NULL)
+		PANIC ("FAT boot sector write failed");
+	memcpy (bounce, &fat_fs->bs, sizeof (fat_fs->bs));
+	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
+	free (bounce);
+}
+
+/* Fills fat_bitmap in.  After a clean shutdown it is read from its own
+ * sectors, a 32nd of the FAT's size; otherwise every FAT entry has to be
+ * looked at.  The boot sector is then marked not clean until fat_close,
+ * so that a crash makes the next mount scan the FAT again. */
 void init_fat_bitmap(void){
-	for(int clst = 0; clst < fat_fs->fat_length; clst++){
-		// FAT occupied with EOC or any value (next cluster)
-		if(fat_fs->fat[clst])
-			bitmap_set(fat_bitmap, clst, true);
+	if (fat_fs->bs.clean && fat_fs->bs.bitmap_sectors > 0) {
+		uint8_t *buf = malloc (DISK_SECTOR_SIZE);
+		if (buf == NULL)
+			PANIC ("FAT bitmap load failed");
+		for (size_t sec = 0; sec < fat_fs->bs.bitmap_sectors; sec++) {
+			size_t first = sec * BITS_PER_SECTOR;
+			disk_read (filesys_disk, fat_fs->bs.bitmap_start + sec, buf);
+			for (size_t i = first; i < fat_fs->fat_length
+					&& i < first + BITS_PER_SECTOR; i++)
+				bitmap_set (fat_bitmap, i,
+						(buf[(i - first) / 8] >> (i % 8)) & 1);
+		}
+		free (buf);
+	} else {
+		for(cluster_t clst = 1; clst <= fat_fs->fat_length; clst++){
+			// FAT occupied with EOC or any value (next cluster)
+			if(*fat_entry (clst))
+				fat_bitmap_set(clst - 1, true);
+		}
 	}
+
+	fat_fs->bs.clean = false;
+	write_boot ();
 }
 
 void
 fat_open (void) {
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
+	// crash 후라면 FAT를 읽기 전에 저널의 transaction부터 제자리에 씀
+	journal_recover ();
+
+	// FAT sector는 fat_entry가 처음 쓰일 때 읽음
+	free (fat_fs->fat);
+	fat_fs->fat = calloc (fat_fs->bs.fat_sectors, DISK_SECTOR_SIZE);
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
+	bitmap_set_all (fat_fs->loaded, false);
+	bitmap_set_all (fat_fs->dirty, false);
+	bitmap_set_all (fat_fs->bitmap_dirty, false);
+	bitmap_set_all (fat_fs->freed, false);
+	bitmap_set_all (fat_fs->freeing, false);
+	bitmap_set_all (fat_fs->written, false);
+}
 
-	// Load FAT directly from the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_read = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_read;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i, buffer + bytes_read);
-			bytes_read += DISK_SECTOR_SIZE;
-		} else {
-			uint8_t *bounce = malloc (DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT load failed");
-			disk_read (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			memcpy (buffer + bytes_read, bounce, bytes_left);
-			bytes_read += bytes_left;
-			free (bounce);
-		}
+/* Writes the bitmap sectors that changed since they were last written.
+ * The bitmap is only read after a clean fat_close, so it goes straight
+ * to disk.  Caller holds write_lock. */
+static void
+write_bitmap (void) {
+	size_t sec;
+
+	if (fat_fs->bs.bitmap_sectors == 0)
+		return;
+
+	uint8_t *buf = malloc (DISK_SECTOR_SIZE);
+	if (buf == NULL)
+		PANIC ("FAT bitmap write failed");
+	while ((sec = bitmap_scan_and_flip (fat_fs->bitmap_dirty, 0, 1, true))
+			!= BITMAP_ERROR) {
+		size_t first = sec * BITS_PER_SECTOR;
+		memset (buf, 0, DISK_SECTOR_SIZE);
+		for (size_t i = first; i < fat_fs->fat_length
+				&& i < first + BITS_PER_SECTOR; i++)
+			if (bitmap_test (fat_bitmap, i))
+				buf[(i - first) / 8] |= 1 << (i % 8);
+		disk_write (filesys_disk, fat_fs->bs.bitmap_start + sec, buf);
+		sync_cnt++;
 	}
+	free (buf);
 }
 
+/* Writes the FAT sectors and bitmap sectors that changed since they were
+ * last written.  Called by journal commits, with no operation running.
+ * FAT sectors go into the journal transaction being committed, and the
+ * clusters freed in them become reusable once fat_release() is called
+ * after the commit. */
 void
-fat_close (void) {
-	// Write FAT boot sector
-	uint8_t *bounce = calloc (1, DISK_SECTOR_SIZE);
-	if (bounce == NULL)
-		PANIC ("FAT close failed");
-	memcpy (bounce, &fat_fs->bs, sizeof (fat_fs->bs));
-	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
-	free (bounce);
-
-	// Write FAT directly to the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
-		}
+fat_flush (void) {
+	size_t sec;
+
+	if (fat_fs == NULL || fat_fs->fat == NULL)
+		return;
+
+	lock_acquire (&fat_fs->write_lock);
+	// 쓰기 전에 dirty를 지워서, 쓰는 도중 바뀐 것은 다음 번에 다시 씀
+	while ((sec = bitmap_scan_and_flip (fat_fs->dirty, 0, 1, true))
+			!= BITMAP_ERROR) {
+		buffer_cache_write_meta (fat_fs->bs.fat_start + sec,
+				fat_fs->fat + sec * FAT_PER_SECTOR, 0, DISK_SECTOR_SIZE);
+		sync_cnt++;
 	}
+	for (size_t idx = 0; (idx = bitmap_scan_and_flip (fat_fs->freed, idx, 1,
+					true)) != BITMAP_ERROR; )
+		bitmap_mark (fat_fs->freeing, idx);
+	write_bitmap ();
+	lock_release (&fat_fs->write_lock);
+}
+
+/* Lets the clusters freed in the FAT sectors of the last fat_flush be
+ * allocated again, now that the journal has committed them.  Reusing
+ * one earlier for file data could, after a crash, leave the chain that
+ * held it pointing at that data. */
+void
+fat_release (void) {
+	if (fat_fs == NULL || fat_fs->fat == NULL)
+		return;
+
+	lock_acquire (&fat_fs->write_lock);
+	for (size_t idx = 0; (idx = bitmap_scan_and_flip (fat_fs->freeing, idx,
+					1, true)) != BITMAP_ERROR; )
+		fat_bitmap_set (idx, false);
+	lock_release (&fat_fs->write_lock);
+}
+
+/* Returns the number of FAT sectors changed since fat_flush. */
+size_t
+fat_dirty_count (void) {
+	if (fat_fs == NULL || fat_fs->fat == NULL)
+		return 0;
+
+	lock_acquire (&fat_fs->write_lock);
+	size_t cnt = bitmap_count (fat_fs->dirty, 0, bitmap_size (fat_fs->dirty),
+			true);
+	lock_release (&fat_fs->write_lock);
+	return cnt;
+}
+
+void
+fat_close (void) {
+	fat_sync_written ();
+	// 남은 metadata를 commit해 제자리에 쓴 뒤 boot sector에 clean 표시.
+	// -journal-crash면 저널에만 남기고 crash처럼 끝냄
+	if (!journal_close ())
+		return;
+	lock_acquire (&fat_fs->write_lock);
+	write_bitmap ();
+	lock_release (&fat_fs->write_lock);
+	buffer_cache_flush ();
+	fat_fs->bs.clean = true;
+	write_boot ();
 }
 
 void
@@ -162,13 +368,24 @@ fat_create (void) {
 	//printf("(fat_create) create fat_bitmap - fat_len %d, bitmap size %d\n", fat_fs->fat_length, bitmap_size(fat_bitmap));
 #endif
 
-	// Create FAT table
-	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
+	// Create FAT table.  It is far larger than a journal transaction, so
+	// it is written straight to disk; only later changes are journaled.
+	fat_fs->fat = calloc (fat_fs->bs.fat_sectors, DISK_SECTOR_SIZE);
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
+	bitmap_set_all (fat_fs->loaded, true);
+	bitmap_set_all (fat_bitmap, false);
+	bitmap_set_all (fat_fs->bitmap_dirty, true);
+	bitmap_set_all (fat_fs->freed, false);
+	bitmap_set_all (fat_fs->freeing, false);
+	bitmap_set_all (fat_fs->written, false);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
+	for (size_t sec = 0; sec < fat_fs->bs.fat_sectors; sec++)
+		disk_write (filesys_disk, fat_fs->bs.fat_start + sec,
+				fat_fs->fat + sec * FAT_PER_SECTOR);
+	bitmap_set_all (fat_fs->dirty, false);
 
 	// Fill up ROOT_DIR_CLUSTER region with 0
 	uint8_t *buf = calloc (1, DISK_SECTOR_SIZE);
@@ -190,7 +407,12 @@ fat_boot_create (void) {
 	    .fat_start = 1, // Sector 0 is BOOT_SECTOR
 	    .fat_sectors = fat_sectors,
 	    .root_dir_cluster = ROOT_DIR_CLUSTER,
+	    .bitmap_start = 1 + fat_sectors,
+	    .bitmap_sectors = DIV_ROUND_UP (disk_size (filesys_disk), BITS_PER_SECTOR),
 	};
+	fat_fs->bs.journal_start = fat_fs->bs.bitmap_start
+		+ fat_fs->bs.bitmap_sectors;
+	fat_fs->bs.journal_sectors = JOURNAL_SECTORS;
 	// ex) total sectors 20160, fat_sectors = 157 -> pintos-mkdisk tmp.dsk 10 값에 따라 달라짐.
 	// tmp.dsk 2라면 
 
@@ -210,7 +432,10 @@ fat_fs_init (void) {
 	// fat_fs->fat_length = fat_fs->bs.fat_sectors * DISK_SECTOR_SIZE / sizeof (cluster_t); // ex) 157 sectors * 512 bytes/sector % 4 bytes/cluster = 20096 clusters in FAT
 
 	// in which sector we can start to store FAT on the disk
-	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	// 예전에 포맷한 디스크는 bitmap_sectors, journal_sectors가 0이라 FAT 바로 뒤부터 데이터
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors
+		+ fat_fs->bs.bitmap_sectors + fat_fs->bs.journal_sectors;
+	journal_open (fat_fs->bs.journal_start, fat_fs->bs.journal_sectors);
 	fat_fs->fat_length = sector_to_cluster(disk_size(filesys_disk))-1;
 
 #ifdef DBG_FAT
@@ -227,38 +452,158 @@ fat_fs_init (void) {
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
-	cluster_t new_clst = get_empty_cluster();
-	if (new_clst != 0){
-		fat_put(new_clst, EOChain);
-		if (clst != 0){
-			fat_put(clst, new_clst);
+	return fat_extend_chain (clst, 1, false);
+}
+
+/* Adds CNT clusters to the chain ending at CLST, or starts a new chain
+ * of CNT clusters if CLST is 0, laying them out contiguously after CLST
+ * where they are free.  If UNWRITTEN is true, the new clusters read as
+ * zeros until fat_set_written() is called on them, and need not be
+ * zeroed on disk.
+ * Returns the first cluster added, or 0 if fails to allocate all of
+ * them, in which case the chain is left as it was. */
+cluster_t
+fat_extend_chain (cluster_t clst, size_t cnt, bool unwritten) {
+	cluster_t first = 0;
+	cluster_t prev = clst;
+
+	ASSERT (cnt > 0);
+
+	lock_acquire (&fat_fs->write_lock);
+	for (size_t i = 0; i < cnt; i++) {
+		cluster_t new_clst = get_empty_cluster (prev);
+		if (new_clst == 0) {
+			// 일부만 할당됐으면 되돌림
+			if (first != 0)
+				remove_chain (first, clst);
+			first = 0;
+			break;
 		}
+		fat_set(new_clst, EOChain | (unwritten ? FAT_UNWRITTEN : 0));
+		bitmap_reset (fat_fs->written, new_clst - 1);
+		if (prev != 0)
+			fat_put(prev, new_clst);
+		if (first == 0)
+			first = new_clst;
+		prev = new_clst;
 	}
-	return new_clst;
+	lock_release (&fat_fs->write_lock);
+	return first;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
-	while(clst && clst != EOChain){
-		bitmap_set(fat_bitmap, clst - 1, false);
-		clst = fat_get(clst);
-	}
+	lock_acquire (&fat_fs->write_lock);
+	remove_chain (clst, pclst);
+	lock_release (&fat_fs->write_lock);
+}
+
+/* Frees CLST and returns the cluster that followed it.  Caller holds
+ * write_lock. */
+static cluster_t
+free_cluster (cluster_t clst) {
+	cluster_t next = fat_get(clst);
+	// 다시 부팅했을 때 init_fat_bitmap이 사용 중으로 보지 않도록 비움.
+	// fat_bitmap에서는 반납이 commit된 뒤에 비움
+	fat_set(clst, 0);
+	bitmap_mark (fat_fs->freed, clst - 1);
+	bitmap_reset (fat_fs->written, clst - 1);
+	return next;
+}
+
+/* fat_remove_chain() with write_lock held. */
+static void
+remove_chain (cluster_t clst, cluster_t pclst) {
+	while(clst && clst != EOChain)
+		clst = free_cluster (clst);
 	if (pclst != 0){
 		fat_put(pclst, EOChain);
 	}
 }
 
-/* Update a value in the FAT table. */
+/* Removes at most CNT clusters from the front of the chain starting at
+ * CLST, and links PCLST, if not 0, to the cluster after them instead.
+ * Returns that cluster, or 0 if the chain has ended.  Changes at most
+ * CNT + 1 FAT sectors, so that a long chain can be freed a journal
+ * operation at a time. */
+cluster_t
+fat_remove_run (cluster_t clst, cluster_t pclst, size_t cnt) {
+	lock_acquire (&fat_fs->write_lock);
+	for (; cnt > 0 && clst != 0 && clst != EOChain; cnt--)
+		clst = free_cluster (clst);
+	if (clst == EOChain)
+		clst = 0;
+	if (pclst != 0)
+		fat_put (pclst, clst != 0 ? clst : EOChain);
+	lock_release (&fat_fs->write_lock);
+	return clst;
+}
+
+/* Starts a new chain of CNT clusters in a row, none of them unwritten,
+ * and returns its first cluster, or 0 if there are not that many free
+ * clusters in a row.  Its FAT entries take up at most
+ * CNT / FAT_PER_SECTOR + 2 FAT sectors. */
+cluster_t
+fat_create_run (size_t cnt) {
+	size_t idx;
+
+	ASSERT (cnt > 0);
+
+	lock_acquire (&fat_fs->write_lock);
+	size_t cursor = fat_fs->last_clst < bitmap_size (fat_bitmap)
+		? fat_fs->last_clst : 0;
+	idx = bitmap_scan (fat_bitmap, cursor, cnt, false);
+	if (idx == BITMAP_ERROR)
+		idx = bitmap_scan (fat_bitmap, 0, cnt, false);
+	if (idx != BITMAP_ERROR) {
+		for (size_t i = 0; i < cnt; i++) {
+			fat_bitmap_set (idx + i, true);
+			bitmap_reset (fat_fs->written, idx + i);
+			fat_set (idx + i + 1, i + 1 < cnt ? idx + i + 2 : EOChain);
+		}
+		fat_fs->last_clst = idx + cnt;
+		alloc_cnt += cnt;
+		contig_cnt += cnt - 1;
+	}
+	lock_release (&fat_fs->write_lock);
+	return idx != BITMAP_ERROR ? idx + 1 : 0;
+}
+
+/* Prints how fragmented the files on disk are: every chain is one file
+ * (with its inode as the first cluster), and every link to a cluster
+ * other than the next one starts another extent.  Only the FAT sectors
+ * read in so far are counted, so that printing does not read the rest. */
+void
+fat_print_stats (void) {
+	unsigned chains = 0, extents = 0;
+
+	for (cluster_t clst = 1; clst <= fat_fs->fat_length; clst++) {
+		if (!bitmap_test (fat_fs->loaded, (clst - 1) / FAT_PER_SECTOR))
+			continue;
+		cluster_t next = fat_get (clst);
+		if (next == EOChain)
+			chains++;
+		else if (next != 0 && next != clst + 1)
+			extents++;
+	}
+	extents += chains;
+	printf ("FAT: %u files in %u extents (%u.%02u per file), "
+			"%lld of %lld clusters allocated contiguously\n",
+			chains, extents, chains ? extents / chains : 0,
+			chains ? extents * 100 / chains % 100 : 0, contig_cnt, alloc_cnt);
+	printf ("FAT: %lld of %u sectors read, %lld sectors written back\n",
+			load_cnt, fat_fs->bs.fat_sectors, sync_cnt);
+}
+
+/* Update a value in the FAT table.  Whether CLST is unwritten is kept. */
 void
 fat_put (cluster_t clst, cluster_t val) {
 	/* TODO: Your code goes here. */
 	ASSERT(clst >= 1);
-	if(!bitmap_test(fat_bitmap, clst - 1)) bitmap_mark(fat_bitmap, clst - 1);
-	fat_fs->fat[clst - 1] = val;
+	if(!bitmap_test(fat_bitmap, clst - 1)) fat_bitmap_set(clst - 1, true);
+	fat_set(clst, (*fat_entry(clst) & FAT_UNWRITTEN) | val);
 }
 
 /* Fetch a value in the FAT table. */
@@ -269,7 +614,76 @@ fat_get (cluster_t clst) {
 
 	if (clst > fat_fs->fat_length || !bitmap_test(fat_bitmap, clst - 1))
 		return 0; // error handling for fat_get(EOChain) or empty
-	return fat_fs->fat[clst - 1];
+	return *fat_entry(clst) & ~FAT_UNWRITTEN;
+}
+
+/* Returns true if CLST belongs to a file but has never been written. */
+bool
+fat_unwritten (cluster_t clst) {
+	bool unwritten;
+
+	ASSERT(clst >= 1);
+	lock_acquire (&fat_fs->write_lock);
+	unwritten = clst <= fat_fs->fat_length && bitmap_test(fat_bitmap, clst - 1)
+		&& (*fat_entry(clst) & FAT_UNWRITTEN) != 0
+		&& !bitmap_test (fat_fs->written, clst - 1);
+	lock_release (&fat_fs->write_lock);
+	return unwritten;
+}
+
+/* Marks CLST as holding data, which the caller is about to write.  Its
+ * FAT entry is updated later by fat_sync_written(), inside a journal
+ * operation; this is called outside of them, by page cache writeback. */
+void
+fat_set_written (cluster_t clst) {
+	ASSERT(clst >= 1 && clst <= fat_fs->fat_length);
+	lock_acquire (&fat_fs->write_lock);
+	bitmap_mark (fat_fs->written, clst - 1);
+	lock_release (&fat_fs->write_lock);
+}
+
+/* Clears the unwritten mark in the FAT entries of the clusters that
+ * fat_set_written() was called on, in journal operations that each
+ * change at most JOURNAL_OP_SECTORS FAT sectors.  Called periodically by
+ * kworkerd, and before the last commit. */
+void
+fat_sync_written (void) {
+	size_t idx = 0;
+
+	if (fat_fs == NULL || fat_fs->fat == NULL)
+		return;
+
+	for (;;) {
+		lock_acquire (&fat_fs->write_lock);
+		idx = bitmap_scan (fat_fs->written, idx, 1, true);
+		lock_release (&fat_fs->write_lock);
+		if (idx == BITMAP_ERROR)
+			return;
+
+		journal_begin ();
+		lock_acquire (&fat_fs->write_lock);
+		size_t secs = 0, last_sec = SIZE_MAX;
+		for (; (idx = bitmap_scan (fat_fs->written, idx, 1, true))
+				!= BITMAP_ERROR; idx++) {
+			cluster_t clst = idx + 1;
+			unsigned int val = *fat_entry (clst);
+			// 앞에서부터 보므로 sector 번호가 바뀔 때만 새 sector
+			if ((val & FAT_UNWRITTEN) != 0
+					&& (clst - 1) / FAT_PER_SECTOR != last_sec) {
+				if (secs == JOURNAL_OP_SECTORS)
+					break;
+				secs++;
+				last_sec = (clst - 1) / FAT_PER_SECTOR;
+			}
+			bitmap_reset (fat_fs->written, idx);
+			if ((val & FAT_UNWRITTEN) != 0)
+				fat_set (clst, val & ~FAT_UNWRITTEN);
+		}
+		lock_release (&fat_fs->write_lock);
+		journal_end ();
+		if (idx == BITMAP_ERROR)
+			return;
+	}
 }
 
 /* Covert a cluster # to a sector number. */
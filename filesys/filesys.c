@@ -6,6 +6,10 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/page_cache.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/dcache.h"
+#include "filesys/journal.h"
 #include "devices/disk.h"
 
 /* The disk that contains the file system. */
@@ -69,6 +73,7 @@ filesys_init (bool format) {
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
 	inode_init ();
+	dcache_init ();
 
 	// Project 3. (parallel-merge)
 	lock_init(&filesys_lock);
@@ -96,8 +101,12 @@ filesys_init (bool format) {
  * to disk. */
 void
 filesys_done (void) {
+	page_cache_flush_all ();
+	inode_flush_all ();
+	buffer_cache_flush ();
 	/* Original FS */
 #ifdef EFILESYS
+	inode_free_chains ();
 	fat_close ();
 #else
 	free_map_close ();
@@ -107,11 +116,16 @@ filesys_done (void) {
 /* Creates a file named NAME with the given INITIAL_SIZE.
  * Returns true if successful, false otherwise.
  * Fails if a file named NAME already exists,
- * or if internal memory allocation fails. */
+ * or if internal memory allocation fails.
+ * The file is created empty in one journal operation and then grown to
+ * INITIAL_SIZE, which may take many clusters, in operations of its own;
+ * if the disk fills up meanwhile it is removed again. */
 bool
 filesys_create (const char *name, off_t initial_size) {
 	bool success = false;
+	disk_sector_t inode_sector = 0;
 
+	journal_begin ();
 	lock_acquire(&filesys_lock);
 
 	// Parse path and get directory
@@ -129,7 +143,6 @@ filesys_create (const char *name, off_t initial_size) {
 		goto done;
 	}
 
-	disk_sector_t inode_sector = 0;
 	// struct dir *dir = dir_open_root ();
 
 	#ifdef EFILESYS
@@ -140,11 +153,11 @@ filesys_create (const char *name, off_t initial_size) {
 	inode_sector = cluster_to_sector(clst);
 
 	success = (dir != NULL			
-			&& inode_create (inode_sector, initial_size, false)
+			&& inode_create (inode_sector, 0, false)
 			&& dir_add (dir, path->filename, inode_sector));
 
 	if (!success)
-		fat_remove_chain (inode_sector, 0);
+		fat_remove_chain (sector_to_cluster (inode_sector), 0);
 
 	// struct path path = parse_filepath(name);
 	// struct dir *dir = dir_open(find_subdir(path.dirnames, path.dircount));
@@ -164,6 +177,17 @@ done:
 	free_path(path);
 done_lock:
 	lock_release(&filesys_lock);
+	journal_end ();
+
+	#ifdef EFILESYS
+	if (success && initial_size > 0) {
+		struct inode *inode = inode_open (inode_sector);
+		success = inode != NULL && inode_extend (inode, initial_size);
+		inode_close (inode);
+		if (!success)
+			filesys_remove (name);
+	}
+	#endif
 
 	return success;
 }
@@ -218,6 +242,7 @@ bool
 filesys_remove (const char *name) {
 	bool success = false;
 
+	journal_begin ();
 	lock_acquire(&filesys_lock);
 
 	// Parse path and get directory
@@ -252,7 +277,7 @@ done:
 	free_path(path);
 done_lock:
 	lock_release(&filesys_lock);
-
+	journal_end ();
 
 	return success;
 }
@@ -267,11 +292,13 @@ do_format (void) {
 	fat_create ();
 	// fat_put(ROOT_DIR_CLUSTER, EOChain); // done in 'fat_create'
 	disk_sector_t rootsect = cluster_to_sector(ROOT_DIR_CLUSTER);
+	journal_begin ();
 	if (!dir_create (rootsect, DISK_SECTOR_SIZE/sizeof (struct dir_entry))) // file number limit
 		PANIC ("root directory creation failed");
 	struct dir* rootdir = dir_open(inode_open(rootsect));
 	dir_add(rootdir, ".", rootsect);
 	dir_close(rootdir);
+	journal_end ();
 	fat_close ();
 #else
 	free_map_create ();
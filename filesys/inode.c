@@ -1,10 +1,17 @@
 #include "filesys/inode.h"
 #include <debug.h>
 #include <round.h>
+#include <stdio.h>
 #include <string.h>
+#include "filesys/buffer_cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/journal.h"
+#include "filesys/page_cache.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 #ifdef EFILESYS
 	#include "filesys/fat.h"
@@ -13,6 +20,14 @@
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Most clusters one journal operation adds to a file: each may need a
+ * FAT sector of its own, besides the previous cluster's and the inode. */
+#define GROW_RUN_MAX (JOURNAL_OP_SECTORS - 2)
+
+/* Most clusters one journal operation frees: each may need a FAT sector
+ * of its own, besides that of the cluster linked to the rest. */
+#define FREE_RUN_MAX (JOURNAL_OP_SECTORS - 1)
+
 /* On-disk inode. // - Moved to inode.h
  * Must be exactly DISK_SECTOR_SIZE bytes long. */
 // struct inode_disk {
@@ -41,21 +56,80 @@ bytes_to_sectors (off_t size) {
 // 	struct inode_disk data;             /* Inode content. */
 // };
 
+#ifdef EFILESYS
+/* The clusters of an open inode's data, in chain order, filled in as
+ * far as they have been looked up.  Files only ever grow at the end of
+ * the chain and the chain is freed only once the last opener is gone,
+ * so the clusters found stay valid for as long as the inode is open;
+ * growth is picked up by the next lookup past the end. */
+struct cluster_map {
+	struct lock lock;
+	cluster_t *clusters;
+	size_t cnt;                         /* Clusters found. */
+	size_t cap;                         /* Size of CLUSTERS. */
+};
+
+/* Returns cluster IDX of INODE's data by walking the FAT chain from its
+ * first cluster, or 0 if the chain is shorter. */
+static cluster_t
+walk_chain (const struct inode *inode, size_t idx) {
+	cluster_t clst = sector_to_cluster(inode->data.start);
+	for (size_t i = 0; i < idx; i++) {
+		clst = fat_get(clst);
+		if (clst == 0)
+			return 0;
+	}
+	return clst;
+}
+
+/* Returns cluster IDX of INODE's data, or 0 if the chain is shorter.
+ * Walks the FAT only past the clusters already in INODE's map. */
+static cluster_t
+lookup_cluster (struct inode *inode, size_t idx) {
+	struct cluster_map *map = inode->map;
+	cluster_t clst = 0;
+
+	if (map == NULL)
+		return walk_chain (inode, idx);
+
+	lock_acquire (&map->lock);
+	while (map->cnt <= idx) {
+		cluster_t next = map->cnt == 0 ? sector_to_cluster (inode->data.start)
+			: fat_get (map->clusters[map->cnt - 1]);
+		if (next == 0 || next == EOChain)
+			break;
+		if (map->cnt == map->cap) {
+			size_t cap = map->cap == 0 ? 16 : map->cap * 2;
+			cluster_t *clusters = realloc (map->clusters, cap * sizeof *clusters);
+			if (clusters == NULL) {
+				// 메모리가 없으면 캐시 없이 처음부터 따라감
+				lock_release (&map->lock);
+				return walk_chain (inode, idx);
+			}
+			map->clusters = clusters;
+			map->cap = cap;
+		}
+		map->clusters[map->cnt++] = next;
+	}
+	if (idx < map->cnt)
+		clst = map->clusters[idx];
+	lock_release (&map->lock);
+	return clst;
+}
+#endif
+
 /* Returns the disk sector that contains byte offset POS within
  * INODE.
  * Returns -1 if INODE does not contain data for a byte at offset
  * POS. */
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
+byte_to_sector (struct inode *inode, off_t pos) {
 	ASSERT (inode != NULL);
 	if (pos < inode->data.length){
 		#ifdef EFILESYS
-			cluster_t clst = sector_to_cluster(inode->data.start);
-			for (unsigned i = 0; i < (pos / DISK_SECTOR_SIZE); i++) {
-					clst = fat_get(clst);
-					if (clst == 0)
-						return -1;
-			}
+			cluster_t clst = lookup_cluster (inode, pos / DISK_SECTOR_SIZE);
+			if (clst == 0)
+				return -1;
 			return cluster_to_sector(clst);
 		#else
 			return inode->data.start + pos / DISK_SECTOR_SIZE;
@@ -65,16 +139,91 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 		return -1;
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Inodes in memory, by sector, so that opening a single inode twice
+ * returns the same `struct inode'.  Besides the open inodes it holds up
+ * to INODE_CLOSED_MAX inodes whose last opener has closed them, with
+ * their data written back, so that opening a file again soon after
+ * needs no disk access for its inode, cluster map or cached pages. */
+static struct hash inode_table;
+/* Closed inodes in the table, most recently closed first. */
+static struct list closed_inodes;
+static size_t closed_cnt;
+/* Protects inode_table and closed_inodes. */
+static struct lock inode_table_lock;
+
+/* 닫힌 뒤에도 남겨 둘 inode 수 */
+#define INODE_CLOSED_MAX 64
+
+#ifdef EFILESYS
+/* Clusters waiting to be freed by inode_free_chains(): those of removed
+ * inodes, whose last opener may be inside a journal operation that has
+ * no room for a large file, and the old data of inodes that
+ * inode_replace_data() gave new clusters. */
+struct old_chain {
+	cluster_t clst;                     /* First cluster to free. */
+	cluster_t pclst;                    /* Cluster linked to it. */
+	struct list_elem elem;
+};
+static struct list removed_inodes;      /* Via elem; not freed yet. */
+static struct list old_chains;
+/* Protects removed_inodes and old_chains. */
+static struct lock chains_lock;
+/* Held while freeing them, so that at shutdown none is left half done. */
+static struct lock free_lock;
+#endif
+
+// 통계: 열려 있던 inode / 닫혀 있던 inode / 디스크에서 읽은 inode
+static long long open_hit_cnt;
+static long long closed_hit_cnt;
+static long long miss_cnt;
+
+static uint64_t
+inode_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct inode, table_elem)->sector);
+}
+
+static bool
+inode_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct inode, table_elem)->sector
+		< hash_entry (b, struct inode, table_elem)->sector;
+}
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	hash_init (&inode_table, inode_hash, inode_less, NULL);
+	list_init (&closed_inodes);
+	lock_init (&inode_table_lock);
+#ifdef EFILESYS
+	list_init (&removed_inodes);
+	list_init (&old_chains);
+	lock_init (&chains_lock);
+	lock_init (&free_lock);
+#endif
+	buffer_cache_init ();
+	journal_init ();
+	page_cache_init ();
 }
 
+#ifdef EFILESYS
+/* Fills the CNT clusters of the chain from CLST with zeros.
+ *
+ * A directory's sectors go through the journal, and the FAT entry that
+ * says a cluster has been written would have to go into the same
+ * transaction as the sector, which the writeback of a directory page
+ * cannot arrange.  So directories are given written clusters of zeros
+ * instead of unwritten ones; the zeros reach the disk with the buffer
+ * cache flush that comes before the commit linking them in. */
+static void
+zero_run (cluster_t clst, size_t cnt) {
+	for (; cnt > 0 && clst != 0 && clst != EOChain; cnt--) {
+		buffer_cache_zero (cluster_to_sector (clst));
+		clst = fat_get (clst);
+	}
+}
+#endif
+
 /* Initializes an inode with LENGTH bytes of data and
  * writes the new inode to sector SECTOR on the file system
  * disk.
@@ -107,42 +256,27 @@ inode_create (disk_sector_t sector, off_t length, bool isdir) {
 		// 	return false; // FAT already occupied
 		// }
 
-		// if(sectors == 0) disk_inode->start = clst;
-		if(sectors == 0) disk_inode->start = cluster_to_sector(fat_create_chain(newclst));
-
-		int i;
-		for (i = 0; i < sectors; i++){
-			// if (i != 0)
-			newclst = fat_create_chain(newclst);
-			if (newclst == 0){ // chain 생성 실패 시 (fails to allocate a new cluster)
-				fat_remove_chain(clst, 0);
-				free(disk_inode);
-				return false;
-			}
-			if (i == 0){
-				clst = newclst;
-				disk_inode->start = cluster_to_sector(newclst); // set start point of the file
-			}
-		}
-		disk_write (filesys_disk, sector, disk_inode);
-		if (sectors > 0) {
-			static char zeros[DISK_SECTOR_SIZE];
-			for (i = 0; i < sectors; i++){
-				ASSERT(clst != 0 || clst != EOChain);
-				disk_write (filesys_disk, cluster_to_sector(clst), zeros); // non-contiguous sectors 
-				clst = fat_get(clst); // find next cluster(=sector) in FAT
-			}
+		// inode 바로 뒤에 이어서 한 번에 할당. 데이터는 unwritten이라 0으로 채울 필요 없음
+		// (길이 0인 파일도 클러스터 하나는 가짐)
+		newclst = fat_extend_chain(clst, sectors > 0 ? sectors : 1, !isdir);
+		if (newclst == 0){ // chain 생성 실패 시 (fails to allocate a new cluster)
+			free(disk_inode);
+			return false;
 		}
+		if (isdir)
+			zero_run (newclst, sectors > 0 ? sectors : 1);
+		disk_inode->start = cluster_to_sector(newclst); // set start point of the file
+		buffer_cache_write_meta (sector, disk_inode, 0, DISK_SECTOR_SIZE);
 		success = true;
 		#else
 		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
+			buffer_cache_write (sector, disk_inode, 0, DISK_SECTOR_SIZE);
 			if (sectors > 0) {
 				static char zeros[DISK_SECTOR_SIZE];
 				size_t i;
 
 				for (i = 0; i < sectors; i++)
-					disk_write (filesys_disk, disk_inode->start + i, zeros);
+					buffer_cache_write_through (disk_inode->start + i, zeros);
 			}
 			success = true; 
 		} 
@@ -157,31 +291,55 @@ inode_create (disk_sector_t sector, off_t length, bool isdir) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
+	struct inode key;
+	struct hash_elem *e;
 	struct inode *inode;
 
-	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
+	lock_acquire (&inode_table_lock);
+
+	/* Check whether this inode is already in memory. */
+	key.sector = sector;
+	e = hash_find (&inode_table, &key.table_elem);
+	if (e != NULL) {
+		inode = hash_entry (e, struct inode, table_elem);
+		if (inode->open_cnt == 0) {
+			// 닫힌 inode 목록에서 꺼내 다시 씀
+			list_remove (&inode->elem);
+			closed_cnt--;
+			closed_hit_cnt++;
+		} else
+			open_hit_cnt++;
+		inode_reopen (inode);
+		lock_release (&inode_table_lock);
+		return inode; 
 	}
+	miss_cnt++;
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release (&inode_table_lock);
 		return NULL;
+	}
 
 	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
+	hash_insert (&inode_table, &inode->table_elem);
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	inode->dirty = false;
+	lock_init (&inode->dir_lock);
+	buffer_cache_read (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	page_cache_open (inode);
+	inode->map = NULL;
+	#ifdef EFILESYS
+	// 할당에 실패하면 byte_to_sector가 매번 FAT을 따라감
+	inode->map = calloc (1, sizeof *inode->map);
+	if (inode->map != NULL)
+		lock_init (&inode->map->lock);
+	#endif
+	lock_release (&inode_table_lock);
 	return inode;
 }
 
@@ -199,33 +357,165 @@ inode_get_inumber (const struct inode *inode) {
 	return inode->sector;
 }
 
+/* Writes INODE's on-disk inode back if it changed.  It goes into the
+ * buffer cache, which writes it to disk after the journal has it. */
+static void
+inode_writeback (struct inode *inode) {
+	if (inode->dirty) {
+		inode->dirty = false;
+		buffer_cache_write_meta (inode->sector, &inode->data, 0,
+				DISK_SECTOR_SIZE);
+	}
+}
+
+/* Writes back every open inode that changed.  Called periodically by
+ * kworkerd and at shutdown. */
+void
+inode_flush_all (void) {
+	struct hash_iterator i;
+
+	lock_acquire (&inode_table_lock);
+	hash_first (&i, &inode_table);
+	while (hash_next (&i))
+		inode_writeback (hash_entry (hash_cur (&i), struct inode, table_elem));
+	lock_release (&inode_table_lock);
+}
+
+/* Returns the number of open inodes that changed since they were last
+ * written back. */
+size_t
+inode_dirty_count (void) {
+	struct hash_iterator i;
+	size_t cnt = 0;
+
+	lock_acquire (&inode_table_lock);
+	hash_first (&i, &inode_table);
+	while (hash_next (&i))
+		if (hash_entry (hash_cur (&i), struct inode, table_elem)->dirty)
+			cnt++;
+	lock_release (&inode_table_lock);
+	return cnt;
+}
+
+/* Frees INODE, which has left the inode table, and its cached pages, and
+ * its blocks if it was removed.  With FAT, the blocks are freed later by
+ * inode_free_chains(), which then frees INODE too. */
+static void
+inode_destroy (struct inode *inode) {
+	/* Write back or drop the cached pages; they must be gone
+	 * before the blocks under them can be reused. */
+	page_cache_close (inode);
+
+	#ifdef EFILESYS
+	if (inode->map != NULL) {
+		free (inode->map->clusters);
+		free (inode->map);
+	}
+	#endif
+
+	/* Deallocate blocks if removed. */
+	if (inode->removed) {
+		#ifdef EFILESYS
+		// 마지막으로 닫는 쪽이 operation 안일 수 있으므로 나눠서 반납하도록 넘김
+		lock_acquire (&chains_lock);
+		list_push_back (&removed_inodes, &inode->elem);
+		lock_release (&chains_lock);
+		return;
+		#else
+		free_map_release (inode->sector, 1);
+		free_map_release (inode->data.start,
+				bytes_to_sectors (inode->data.length)); 
+		#endif
+	}
+
+	free (inode); 
+}
+
+#ifdef EFILESYS
+/* Frees the chain from CLST, which PCLST links to if it is not 0,
+ * FREE_RUN_MAX clusters per journal operation. */
+static void
+free_chain (cluster_t clst, cluster_t pclst) {
+	while (clst != 0 && clst != EOChain) {
+		journal_begin ();
+		clst = fat_remove_run (clst, pclst, FREE_RUN_MAX);
+		journal_end ();
+	}
+}
+#endif
+
+/* Frees the clusters of the removed inodes closed for the last time and
+ * the old data of replaced inodes, a few at a time in journal operations
+ * of their own.  Called periodically by kworkerd and at shutdown, never
+ * within an operation.  A crash before then leaves those clusters
+ * allocated but in no file. */
+void
+inode_free_chains (void) {
+#ifdef EFILESYS
+	ASSERT (thread_current ()->journal_depth == 0);
+
+	lock_acquire (&free_lock);
+	for (;;) {
+		struct inode *inode = NULL;
+		struct old_chain *oc = NULL;
+
+		// 옛 데이터부터: 그 inode가 지워졌으면 뒤에 온 그 inode의 반납이 전부 풀기 전에
+		// 옛 chain을 떼어 내야 함
+		lock_acquire (&chains_lock);
+		if (!list_empty (&old_chains))
+			oc = list_entry (list_pop_front (&old_chains), struct old_chain,
+					elem);
+		else if (!list_empty (&removed_inodes))
+			inode = list_entry (list_pop_front (&removed_inodes),
+					struct inode, elem);
+		lock_release (&chains_lock);
+
+		if (oc != NULL) {
+			free_chain (oc->clst, oc->pclst);
+			free (oc);
+		} else if (inode != NULL) {
+			free_chain (sector_to_cluster (inode->sector), 0);
+			free (inode);
+		} else
+			break;
+	}
+	lock_release (&free_lock);
+#endif
+}
+
 /* Closes INODE and writes it to disk.
- * If this was the last reference to INODE, frees its memory.
- * If INODE was also a removed inode, frees its blocks. */
+ * If this was the last reference to INODE, keeps it among the recently
+ * closed inodes, freeing the least recently closed one if there are too
+ * many.  If INODE was a removed inode, frees it and its blocks instead. */
 void
 inode_close (struct inode *inode) {
+	struct inode *victim = NULL;
+
 	/* Ignore null pointer. */
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
+	lock_acquire (&inode_table_lock);
 	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
-
-		/* Deallocate blocks if removed. */
 		if (inode->removed) {
-			#ifdef EFILESYS
-			fat_remove_chain(sector_to_cluster(inode->sector), 0); // #ifdef DBG 아래처럼 inode->data.start와 inode->sector 둘로 나눌까
-			#else
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
-			#endif
+			hash_delete (&inode_table, &inode->table_elem);
+			victim = inode;
+		} else {
+			// 길이 등이 바뀌었으면 여기서 한 번만 기록
+			inode_writeback (inode);
+			list_push_front (&closed_inodes, &inode->elem);
+			if (++closed_cnt > INODE_CLOSED_MAX) {
+				victim = list_entry (list_pop_back (&closed_inodes),
+						struct inode, elem);
+				hash_delete (&inode_table, &victim->table_elem);
+				closed_cnt--;
+			}
 		}
-
-		free (inode); 
 	}
+	lock_release (&inode_table_lock);
+
+	if (victim != NULL)
+		inode_destroy (victim);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -240,12 +530,69 @@ inode_remove (struct inode *inode) {
  
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
  * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
+ * than SIZE if an error occurs or end of file is reached.
+ * The data comes from the page cache, which reads whole pages from
+ * disk on a miss. */
 off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
+
+	while (size > 0) {
+		/* Bytes left in inode, bytes left in page, lesser of the two. */
+		off_t inode_left = inode_length (inode) - offset;
+		int page_left = PGSIZE - offset % PGSIZE;
+		int min_left = inode_left < page_left ? inode_left : page_left;
+
+		/* Number of bytes to actually copy out of this page. */
+		int chunk_size = size < min_left ? size : min_left;
+		if (chunk_size <= 0)
+			break;
+
+		// 캐시에 자리가 없으면 예전처럼 디스크에서 바로 읽음
+		if (!page_cache_read (inode, buffer + bytes_read, chunk_size, offset)
+				&& inode_read_sectors (inode, buffer + bytes_read, chunk_size,
+					offset) != chunk_size)
+			break;
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_read += chunk_size;
+	}
+	return bytes_read;
+}
+
+/* Returns true if SECTOR belongs to a file but has never been written,
+ * so that it reads as zeros. */
+static bool
+sector_unwritten (disk_sector_t sector) {
+#ifdef EFILESYS
+	return fat_unwritten (sector_to_cluster (sector));
+#else
+	return false;
+#endif
+}
+
+/* Marks SECTOR as holding data. */
+static void
+sector_set_written (disk_sector_t sector UNUSED) {
+#ifdef EFILESYS
+	fat_set_written (sector_to_cluster (sector));
+#endif
+}
+
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET,
+ * bypassing the page cache: whole sectors come from disk and partial
+ * ones through the buffer cache, and sectors never written are zeros.  Used by the page cache to fill its
+ * pages.
+ * Returns the number of bytes actually read, which may be less
+ * than SIZE if an error occurs or end of file is reached. */
+off_t
+inode_read_sectors (struct inode *inode, void *buffer_, off_t size,
+		off_t offset) {
+	uint8_t *buffer = buffer_;
+	off_t bytes_read = 0;
 
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
@@ -262,19 +609,16 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
+		if (sector_unwritten (sector_idx)) {
+			/* Never written: zeros, without reading the disk. */
+			memset (buffer + bytes_read, 0, chunk_size);
+		} else if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
 			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
+			buffer_cache_read_through (sector_idx, buffer + bytes_read);
 		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+			/* Partially copy the sector out of the buffer cache. */
+			buffer_cache_read (sector_idx, buffer + bytes_read, sector_ofs,
+					chunk_size);
 		}
 
 		/* Advance. */
@@ -282,11 +626,82 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
 
 	return bytes_read;
 }
 
+#ifdef EFILESYS
+/* Adds CNT clusters after ENDCLST, the last cluster of a file, all or
+ * none: unwritten ones, or for a directory ones filled with zeros.  They
+ * are added GROW_RUN_MAX at a time, each run in its own journal
+ * operation so that none is too big for a transaction; a crash in
+ * between leaves some of them past the end of the file, which is
+ * harmless. */
+static bool
+grow_chain (cluster_t endclst, size_t cnt, bool isdir) {
+	cluster_t tail = endclst;
+
+	while (cnt > 0) {
+		size_t run = cnt < GROW_RUN_MAX ? cnt : GROW_RUN_MAX;
+		journal_begin ();
+		cluster_t clst = fat_extend_chain (tail, run, !isdir);
+		journal_end ();
+		if (clst == 0) {
+			// 앞에서 단 클러스터도 떼어 냄
+			if (tail != endclst)
+				free_chain (fat_get (endclst), endclst);
+			return false;
+		}
+		if (isdir)
+			zero_run (clst, run);
+		cnt -= run;
+		for (tail = clst; --run > 0; )
+			tail = fat_get (tail);
+	}
+	return true;
+}
+
+/* Adds clusters to the end of INODE's chain until it has room for
+ * LENGTH bytes.  Does not change INODE's length.  Returns false if the
+ * disk is full. */
+static bool
+grow_to (struct inode *inode, off_t length) {
+	off_t inode_len = inode_length (inode);
+	cluster_t endclst = sector_to_cluster (byte_to_sector (inode, inode_len - 1));
+	size_t have = inode_len == 0 ? 1 : bytes_to_sectors (inode_len);
+	size_t need = bytes_to_sectors (length);
+	cluster_t next;
+
+	// 예전 방식으로 늘린 파일은 길이보다 클러스터가 하나 더 달려 있을 수 있음
+	while ((next = fat_get (endclst)) != 0 && next != EOChain) {
+		endclst = next;
+		have++;
+	}
+	return need <= have || grow_chain (endclst, need - have, inode->data.isdir);
+}
+#endif
+
+/* Makes INODE, which was just created with no data, LENGTH bytes long,
+ * the new bytes reading as zeros.  Unlike inode_create() this may add
+ * any number of clusters, since it does so in journal operations of its
+ * own; the caller must not be within one.  Returns false if the disk is
+ * full, leaving INODE as it was. */
+bool
+inode_extend (struct inode *inode, off_t length) {
+	ASSERT (thread_current ()->journal_depth == 0);
+	if (length <= inode_length (inode))
+		return true;
+#ifdef EFILESYS
+	if (!grow_to (inode, length))
+		return false;
+#endif
+	journal_begin ();
+	inode->data.length = length;
+	inode->dirty = true;
+	journal_end ();
+	return true;
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
  * less than SIZE if end of file is reached or an error occurs.
@@ -297,66 +712,78 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
-	
+
 	bool grow = false; // extend marker
-	uint8_t zero[DISK_SECTOR_SIZE]; // buffer for zero padding
 
 	if (inode->deny_write_cnt)
 		return 0;
 
-	/* Sector to write, starting byte offset within sector. */
-	// check if there is enough memory for writing 'size' from 'offset'
-	disk_sector_t sector_idx = byte_to_sector (inode, offset + size);
-
 	// Project 4-1 : File growth
 	#ifdef EFILESYS
-	while (sector_idx == -1){
+	/* New clusters are left unwritten: they read as zeros, so neither
+	 * they nor the gap a write past the end leaves need writing now.
+	 * Bytes past the end of the last sector are zeros already, since a
+	 * sector is filled with zeros when it is first written. */
+	if (offset + size > inode_length (inode) && grow_to (inode, offset + size)) {
 		grow = true; // mark that the extend occured
-		off_t inode_len = inode_length(inode);
-
-		// if(((offset + size - inode_len) <= DISK_SECTOR_SIZE) && (offset + size) / DISK_SECTOR_SIZE == inode_len / DISK_SECTOR_SIZE){ 
-		// 	// in-sector growth(bytes to be written <= sector size, last byte after write lies within current last sector)
-		// 	off_t inode_ofs = inode_len % DISK_SECTOR_SIZE;
-		// 	inode->data.length += DISK_SECTOR_SIZE - inode_ofs;
-		// 	// sector_idx = byte_to_sector(inode, offset + size);
-		// 	break;
-		// }
-		
-		// Extending file
-		cluster_t endclst = sector_to_cluster(byte_to_sector(inode, inode_len - 1));
-		cluster_t newclst = inode_len == 0 ? endclst : fat_create_chain(endclst);
-		if (newclst == 0){
-			break; //no more space in disk
-			// #ifdef DBG Q. return 안하고, 그냥 있는 공간 가지고 write 진행? 근데 이런 상황은 테스트 안할 것 같기도
-		}
+		inode->data.length = offset + size;
+	}
+	#endif
 
-		// Zero padding
-		memset (zero, 0, DISK_SECTOR_SIZE);
-
-		off_t inode_ofs = inode_len % DISK_SECTOR_SIZE;
-		if(inode_ofs != 0)
-			inode->data.length += DISK_SECTOR_SIZE - inode_ofs; // round up to DISK_SECTOR_SIZE for convinience
-		// #ifdef Q. What if inode_ofs == 0? Unnecessary sector added -> unnecessary가 아님. extend 중이니까! 
-
-		disk_write (filesys_disk, cluster_to_sector(newclst), zero); // zero padding for new cluster
-		if (inode_ofs != 0){
-			disk_read (filesys_disk, cluster_to_sector(endclst), zero);
-			memset (zero + inode_ofs + 1 , 0, DISK_SECTOR_SIZE - inode_ofs);
-			disk_write (filesys_disk, cluster_to_sector(endclst), zero); // zero padding for current cluster
-			/*
-					endclst          newclst (extended)
-				 ---------------     ------------
-				| data  0 0 0 0 | - | 0 0 0 0 0 |
-				 ---------------     -----------
-						↑ zero padding here!
-			*/
-		}
+	while (size > 0) {
+		/* Bytes left in inode, bytes left in page, lesser of the two. */
+		off_t inode_left = inode_length (inode) - offset;
+		int page_left = PGSIZE - offset % PGSIZE;
+		int min_left = inode_left < page_left ? inode_left : page_left;
+
+		/* Number of bytes to actually write into this page. */
+		int chunk_size = size < min_left ? size : min_left;
+		if (chunk_size <= 0)
+			break;
+
+		// 캐시 페이지에 쓰고 dirty로 표시. 디스크에는 kworkerd나 close가 기록
+		if (!page_cache_write (inode, buffer + bytes_written, chunk_size, offset)
+				&& inode_write_sectors (inode, buffer + bytes_written,
+					chunk_size, offset) != chunk_size)
+			break;
 
-		inode->data.length += DISK_SECTOR_SIZE; // update file length
-		sector_idx = byte_to_sector (inode, offset + size);
-	}		
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_written += chunk_size;
+	}
+	#ifdef EFILESYS
+		if (grow == true){
+			inode->data.length = offset; // correct inode length
+		}
+		// #ifdef DBG Q. 이미 위 file growth 할때 inode->data.length 바꾸고 있잖아. 그리고 offset + size가 length?는 아니지 않나
 	#endif
+	// free (zero);
+
+	// 길이가 바뀐 경우에만 표시. close나 kworkerd가 몇 번의 변경을 모아 한 번에 기록.
+	// 표시도 operation 안에서 해야 journal_begin이 commit할 양을 셀 때 빠지지 않음
+	if (grow) {
+		journal_begin ();
+		inode->dirty = true;
+		journal_end ();
+	}
+
+	return bytes_written;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET,
+ * bypassing the page cache: whole sectors go to disk and partial ones
+ * into the buffer cache.  A directory's sectors are metadata and all go
+ * into the buffer cache, to reach the disk through the journal.  Used by
+ * the page cache to write its pages back.  Never grows INODE.
+ * Returns the number of bytes actually written, which may be
+ * less than SIZE if end of file is reached or an error occurs. */
+off_t
+inode_write_sectors (struct inode *inode, const void *buffer_, off_t size,
+		off_t offset) {
+	const uint8_t *buffer = buffer_;
+	off_t bytes_written = 0;
+	disk_sector_t sector_idx;
 
 	sector_idx = byte_to_sector (inode, offset); // start writing from offset
 
@@ -373,25 +800,23 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
+		bool unwritten = sector_unwritten (sector_idx);
+		if (inode->data.isdir) {
+			if (unwritten && chunk_size < DISK_SECTOR_SIZE)
+				buffer_cache_zero (sector_idx);
+			buffer_cache_write_meta (sector_idx, buffer + bytes_written,
+					sector_ofs, chunk_size);
+		} else if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
 			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
+			buffer_cache_write_through (sector_idx, buffer + bytes_written);
 		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
+			/* Merge the chunk into the cached sector, which reads in
+			   the rest of the sector first, or starts from zeros if it
+			   was never written. */
+			if (unwritten)
+				buffer_cache_zero (sector_idx);
+			buffer_cache_write (sector_idx, buffer + bytes_written, sector_ofs,
+					chunk_size);
 
 			#ifdef EFILESYS
 				// if (grow == true && size - chunk_size == 0) // last chunk
@@ -403,10 +828,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 				그리고 'EOF'는 character가 아니라 memset엔 못쓸텐데, 고쳐야 하는거 맞지?
 				*/
 			#endif
-			
-			disk_write (filesys_disk, sector_idx, bounce); 
 		}
 
+		if (unwritten)
+			sector_set_written (sector_idx);
+
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
@@ -414,16 +840,6 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	
 		sector_idx = byte_to_sector (inode, offset);
 	}
-	#ifdef EFILESYS
-		if (grow == true){
-			inode->data.length = offset; // correct inode length
-		}
-		// #ifdef DBG Q. 이미 위 file growth 할때 inode->data.length 바꾸고 있잖아. 그리고 offset + size가 length?는 아니지 않나
-	#endif
-	free (bounce);
-	// free (zero);
-
-	disk_write (filesys_disk, inode->sector, &inode->data); 
 
 	return bytes_written;
 }
@@ -447,6 +863,13 @@ inode_allow_write (struct inode *inode) {
 	inode->deny_write_cnt--;
 }
 
+/* Prints inode table statistics. */
+void
+inode_print_stats (void) {
+	printf ("Inode table: %lld open hits, %lld closed hits, %lld misses\n",
+			open_hit_cnt, closed_hit_cnt, miss_cnt);
+}
+
 /* Returns the length, in bytes, of INODE's data. */
 off_t
 inode_length (const struct inode *inode) {
@@ -456,4 +879,71 @@ inode_length (const struct inode *inode) {
 // project 4-2
 bool inode_isdir (struct inode *inode) {
 	return inode->data.isdir;
+}
+
+/* Returns true if the directory INODE holds places its entries by the
+ * hash of their names (filesys/directory.c). */
+bool
+inode_dir_hashed (const struct inode *inode) {
+	return inode->data.dir_hashed;
+}
+
+/* Returns how many slots of the hashed directory INODE holds have ever
+ * been used, live entries and removed ones together. */
+size_t
+inode_dir_used (const struct inode *inode) {
+	return inode->data.dir_used;
+}
+
+#ifdef EFILESYS
+/* Makes the CNT sectors in a row from START, a chain made by
+ * fat_create_run() whose LENGTH bytes of data are on disk already,
+ * INODE's data in place of its old clusters.  Those are freed later by
+ * inode_free_chains(); until then they stay linked after the new ones,
+ * past the end of the file, so that a crash leaves them in a chain
+ * still.  INODE's cached pages, which hold the old data, are dropped
+ * without being written back.  Called within a journal operation, by
+ * the only thread that changes INODE's data.  Returns false if memory
+ * runs out, leaving INODE as it was. */
+bool
+inode_replace_data (struct inode *inode, disk_sector_t start, size_t cnt,
+		off_t length) {
+	cluster_t first = sector_to_cluster (start);
+	struct old_chain *oc = malloc (sizeof *oc);
+	if (oc == NULL)
+		return false;
+
+	/* Drop the old pages before the switch, so that no writeback puts
+	 * them in the new clusters, and again after it, in case a reader
+	 * brought some of the old data in meanwhile. */
+	page_cache_drop (inode);
+	oc->clst = sector_to_cluster (inode->data.start);
+	oc->pclst = first + cnt - 1;
+	fat_put (sector_to_cluster (inode->sector), first);
+	fat_put (oc->pclst, oc->clst);
+	if (inode->map != NULL)
+		lock_acquire (&inode->map->lock);
+	inode->data.start = start;
+	inode->data.length = length;
+	if (inode->map != NULL) {
+		inode->map->cnt = 0;
+		lock_release (&inode->map->lock);
+	}
+	inode->dirty = true;
+	page_cache_drop (inode);
+
+	lock_acquire (&chains_lock);
+	list_push_back (&old_chains, &oc->elem);
+	lock_release (&chains_lock);
+	return true;
+}
+#endif
+
+/* Records whether the directory INODE holds is HASHED and how many of its
+ * slots are USED. */
+void
+inode_set_dir_index (struct inode *inode, bool hashed, size_t used) {
+	inode->data.dir_hashed = hashed;
+	inode->data.dir_used = used;
+	inode->dirty = true;
 }
\ No newline at end of file
@@ -0,0 +1,422 @@
+/* journal.c: Write-ahead journal of file system metadata.
+ *
+ * FAT sectors, inode sectors and directory sectors are not written in
+ * place until they are safely in the journal, a run of JOURNAL_SECTORS
+ * sectors after the free cluster bitmap.  Every metadata write puts the
+ * new contents of its sector into the running transaction, kept in
+ * memory here, which holds the newest image of each sector changed
+ * since the last commit.
+ *
+ * Whatever changes metadata does so inside an operation, bracketed by
+ * journal_begin() and journal_end(): creating or removing a file,
+ * making a directory or a symbolic link, adding clusters to a file.  A
+ * commit waits until no operation is running and keeps new ones from
+ * starting, then pushes the directory pages, inodes and FAT sectors the
+ * finished operations left in memory into the transaction, so that it
+ * holds every operation before it whole and none after it.  It logs the
+ * transaction: a header listing where the sectors belong, the sectors
+ * themselves, and a commit record, written one after another.  Only
+ * then are they written in place, after which the journal is emptied.
+ * kworkerd commits every few seconds, so that sectors changed many times
+ * in between reach the disk once.
+ *
+ * Each operation reserves JOURNAL_OP_SECTORS sectors of the transaction
+ * when it begins.  When the reservations would not fit, journal_begin()
+ * counts what is really waiting to be committed, and commits first if
+ * that does not leave room either.  No operation changes more than it
+ * reserved, and nothing changes metadata outside one, so a transaction
+ * never fills up: work that could change more, such as freeing a large
+ * file or clearing the unwritten marks of the clusters written lately,
+ * is split into operations of its own (filesys/inode.c, filesys/fat.c).
+ *
+ * A crash leaves at most one transaction in the journal.  If its commit
+ * record made it to disk, mounting copies its sectors into place again;
+ * otherwise none of it was written in place and it is ignored. */
+
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/journal.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "filesys/page_cache.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Identify the journal header and commit record. */
+#define JOURNAL_MAGIC 0x4a524e4c
+#define COMMIT_MAGIC 0x434d4954
+
+/* First sector of the journal: the transaction in it. */
+struct journal_header {
+	uint32_t magic;                 /* JOURNAL_MAGIC. */
+	uint32_t seq;                   /* Transaction number. */
+	uint32_t cnt;                   /* Sectors logged, 0 if none. */
+	disk_sector_t sectors[(DISK_SECTOR_SIZE - 12) / sizeof (disk_sector_t)];
+};
+
+/* Written right after the logged sectors, last. */
+struct journal_commit {
+	uint32_t magic;                 /* COMMIT_MAGIC. */
+	uint32_t seq;                   /* Same as the header's. */
+	uint32_t checksum;              /* Of the header and logged sectors. */
+	uint8_t unused[DISK_SECTOR_SIZE - 12];
+};
+
+bool journal_crash;
+
+static disk_sector_t journal_start;
+static size_t journal_size;
+static size_t txn_max;              /* Sectors per transaction, 0 if none. */
+static uint32_t journal_seq;
+
+/* The running transaction.  Protected by txn_lock, which is held across
+ * the disk I/O of a commit. */
+static struct lock txn_lock;
+static size_t txn_len;
+static disk_sector_t txn_sectors[JOURNAL_TXN_MAX];
+static uint8_t *txn_images;         /* JOURNAL_TXN_MAX sectors. */
+
+/* Operations and commits.  Protected by op_lock. */
+static struct lock op_lock;
+static struct condition op_done;    /* An operation or a commit finished. */
+static size_t op_cnt;               /* Operations running. */
+static size_t reserved;             /* Sectors the transaction may reach. */
+static bool committing;             /* No operation may begin. */
+
+// 통계
+static long long op_total;          /* Operations begun. */
+static long long txn_cnt;           /* Transactions committed. */
+static long long logged_cnt;        /* Sectors written to the journal. */
+static long long replay_cnt;        /* Sectors copied into place on mount. */
+
+/* Adds CNT bytes at DATA into checksum SUM. */
+static uint32_t
+checksum (uint32_t sum, const void *data, size_t cnt) {
+	const uint8_t *p = data;
+	while (cnt-- > 0)
+		sum = sum * 31 + *p++;
+	return sum;
+}
+
+/* Initializes the journal, before the file system is opened. */
+void
+journal_init (void) {
+	lock_init (&txn_lock);
+	lock_init (&op_lock);
+	cond_init (&op_done);
+}
+
+/* Uses the SECTORS sectors from START for the journal.  A volume with
+ * too little room for it, formatted before there was a journal, writes
+ * its metadata in place directly. */
+void
+journal_open (disk_sector_t start, size_t sectors) {
+	ASSERT (JOURNAL_TXN_MAX
+			<= sizeof ((struct journal_header *) 0)->sectors
+			/ sizeof (disk_sector_t));
+	journal_start = start;
+	// 예전에 포맷한 볼륨은 저널이 작을 수 있음
+	txn_max = sectors > 2 ? sectors - 2 : 0;
+	if (txn_max > JOURNAL_TXN_MAX)
+		txn_max = JOURNAL_TXN_MAX;
+	if (txn_max < JOURNAL_OP_SECTORS)
+		txn_max = 0;
+	journal_size = txn_max > 0 ? sectors : 0;
+
+	if (txn_max > 0 && txn_images == NULL) {
+		txn_images = malloc (JOURNAL_TXN_MAX * DISK_SECTOR_SIZE);
+		if (txn_images == NULL)
+			PANIC ("journal init failed");
+	}
+}
+
+/* Returns true if metadata goes through the journal. */
+bool
+journal_enabled (void) {
+	return txn_max > 0;
+}
+
+/* Writes the header of an empty journal. */
+static void
+write_empty (void) {
+	struct journal_header *h = calloc (1, sizeof *h);
+	if (h == NULL)
+		PANIC ("journal write failed");
+	h->magic = JOURNAL_MAGIC;
+	h->seq = journal_seq;
+	disk_write (filesys_disk, journal_start, h);
+	free (h);
+}
+
+/* Returns the index of SECTOR in the running transaction, or -1.
+ * Caller holds txn_lock. */
+static int
+txn_find (disk_sector_t sector) {
+	for (size_t i = 0; i < txn_len; i++)
+		if (txn_sectors[i] == sector)
+			return i;
+	return -1;
+}
+
+/* Logs the running transaction, then, if CHECKPOINT, writes it in place
+ * and empties the journal.  Caller holds txn_lock. */
+static void
+txn_commit (bool checkpoint) {
+	if (txn_len == 0)
+		return;
+
+	struct journal_header *h = calloc (1, sizeof *h);
+	struct journal_commit *c = calloc (1, sizeof *c);
+	if (h == NULL || c == NULL)
+		PANIC ("journal write failed");
+
+	h->magic = JOURNAL_MAGIC;
+	h->seq = ++journal_seq;
+	h->cnt = txn_len;
+	memcpy (h->sectors, txn_sectors, txn_len * sizeof *txn_sectors);
+	uint32_t sum = checksum (0, h, sizeof *h);
+
+	// 헤더, 섹터들, commit record 순서로 이어서 씀. commit record가 마지막
+	disk_write (filesys_disk, journal_start, h);
+	for (size_t i = 0; i < txn_len; i++) {
+		const void *image = txn_images + i * DISK_SECTOR_SIZE;
+		disk_write (filesys_disk, journal_start + 1 + i, image);
+		sum = checksum (sum, image, DISK_SECTOR_SIZE);
+	}
+	c->magic = COMMIT_MAGIC;
+	c->seq = h->seq;
+	c->checksum = sum;
+	disk_write (filesys_disk, journal_start + 1 + txn_len, c);
+
+	txn_cnt++;
+	logged_cnt += txn_len;
+	free (c);
+	free (h);
+
+	if (!checkpoint)
+		return;
+	for (size_t i = 0; i < txn_len; i++)
+		disk_write (filesys_disk, txn_sectors[i],
+				txn_images + i * DISK_SECTOR_SIZE);
+	// 반납된 섹터가 파일 데이터로 재사용된 뒤 crash가 나도 옛 내용을 다시 쓰지 않도록 비움
+	write_empty ();
+	txn_len = 0;
+}
+
+/* Puts IMAGE, the new contents of metadata SECTOR, into the running
+ * transaction.  The reservations of journal_begin() leave room for it. */
+void
+journal_add (disk_sector_t sector, const void *image) {
+	ASSERT (journal_enabled ());
+
+	lock_acquire (&txn_lock);
+	int i = txn_find (sector);
+	if (i < 0) {
+		// 여기서 넘치면 어떤 operation이 JOURNAL_OP_SECTORS보다 많이 바꾼 것
+		ASSERT (txn_len < txn_max);
+		i = txn_len++;
+		txn_sectors[i] = sector;
+	}
+	memcpy (txn_images + i * DISK_SECTOR_SIZE, image, DISK_SECTOR_SIZE);
+	lock_release (&txn_lock);
+}
+
+/* Copies the contents of SECTOR into BUFFER if the running transaction
+ * has it, which is newer than the disk.  Returns true if so. */
+bool
+journal_read (disk_sector_t sector, void *buffer) {
+	if (!journal_enabled ())
+		return false;
+
+	lock_acquire (&txn_lock);
+	int i = txn_find (sector);
+	if (i >= 0)
+		memcpy (buffer, txn_images + i * DISK_SECTOR_SIZE, DISK_SECTOR_SIZE);
+	lock_release (&txn_lock);
+	return i >= 0;
+}
+
+/* Returns how many sectors the next commit would log now, at most.
+ * Caller holds op_lock. */
+static size_t
+journal_pending (void) {
+	lock_acquire (&txn_lock);
+	size_t cnt = txn_len;
+	lock_release (&txn_lock);
+
+	cnt += page_cache_dirty_dirs () + inode_dirty_count ();
+#ifdef EFILESYS
+	cnt += fat_dirty_count ();
+#endif
+	return cnt;
+}
+
+/* Waits for the running operations to end and commits everything they
+ * changed as one transaction, writing it in place if CHECKPOINT.  If
+ * another thread is already committing, waits for it instead. */
+static void
+commit (bool checkpoint) {
+	lock_acquire (&op_lock);
+	if (committing) {
+		while (committing)
+			cond_wait (&op_done, &op_lock);
+		lock_release (&op_lock);
+		return;
+	}
+	committing = true;
+	while (op_cnt > 0)
+		cond_wait (&op_done, &op_lock);
+	lock_release (&op_lock);
+
+	// 끝난 operation들이 메모리에만 남긴 metadata를 모두 transaction에 넣음
+	page_cache_flush_dirs ();
+	inode_flush_all ();
+#ifdef EFILESYS
+	fat_flush ();
+#endif
+	// FAT가 이미 쓴 것으로 표시한 부분 섹터가 commit보다 먼저 디스크에 가도록
+	buffer_cache_flush ();
+
+	lock_acquire (&txn_lock);
+	txn_commit (checkpoint);
+	lock_release (&txn_lock);
+#ifdef EFILESYS
+	// 반납이 디스크에 남았으니 이제 그 클러스터를 다시 써도 됨
+	if (checkpoint)
+		fat_release ();
+#endif
+
+	lock_acquire (&op_lock);
+	committing = false;
+	reserved = 0;
+	cond_broadcast (&op_done, &op_lock);
+	lock_release (&op_lock);
+}
+
+/* Begins an operation that changes metadata.  A commit never falls in
+ * the middle of one.  Operations nest; only the outermost pair counts.
+ * The caller must not hold any lock a running operation might wait for,
+ * since this may wait for all of them to end. */
+void
+journal_begin (void) {
+	if (thread_current ()->journal_depth++ > 0)
+		return;
+
+	lock_acquire (&op_lock);
+	while (committing
+			|| (journal_enabled ()
+				&& reserved + JOURNAL_OP_SECTORS > txn_max)) {
+		if (committing) {
+			cond_wait (&op_done, &op_lock);
+			continue;
+		}
+		// 예약은 operation마다 최악의 경우로 잡으므로 실제로 쌓인 양으로 다시 셈
+		reserved = journal_pending () + op_cnt * JOURNAL_OP_SECTORS;
+		if (reserved + JOURNAL_OP_SECTORS <= txn_max)
+			break;
+		lock_release (&op_lock);
+		commit (true);
+		lock_acquire (&op_lock);
+	}
+	op_cnt++;
+	op_total++;
+	reserved += JOURNAL_OP_SECTORS;
+	lock_release (&op_lock);
+}
+
+/* Ends the operation begun by the matching journal_begin(). */
+void
+journal_end (void) {
+	struct thread *t = thread_current ();
+
+	ASSERT (t->journal_depth > 0);
+	if (--t->journal_depth > 0)
+		return;
+
+	lock_acquire (&op_lock);
+	if (--op_cnt == 0)
+		cond_broadcast (&op_done, &op_lock);
+	lock_release (&op_lock);
+}
+
+/* Commits the metadata changed by the operations that ended since the
+ * last commit.  Called periodically by kworkerd. */
+void
+journal_commit (void) {
+	commit (true);
+}
+
+/* Commits what is left at shutdown.  Returns true if it was written in
+ * place as well.  With -journal-crash it is left in the journal only, as
+ * if the machine lost power right after the commit record reached the
+ * disk, for the next mount to replay; returns false then. */
+bool
+journal_close (void) {
+	commit (!journal_crash);
+	return !journal_crash;
+}
+
+/* Copies the sectors of a committed transaction left in the journal by
+ * a crash into place, then empties the journal.  Called on mount before
+ * any metadata is read. */
+void
+journal_recover (void) {
+	if (!journal_enabled ())
+		return;
+
+	struct journal_header *h = malloc (sizeof *h);
+	struct journal_commit *c = malloc (sizeof *c);
+	uint8_t *buf = malloc (DISK_SECTOR_SIZE);
+	if (h == NULL || c == NULL || buf == NULL)
+		PANIC ("journal recovery failed");
+
+	disk_read (filesys_disk, journal_start, h);
+	if (h->magic != JOURNAL_MAGIC) {
+		// 저널을 처음 쓰는 볼륨
+		journal_seq = 0;
+		write_empty ();
+	} else {
+		journal_seq = h->seq;
+		if (h->cnt > 0 && h->cnt <= JOURNAL_TXN_MAX
+				&& h->cnt + 2 <= journal_size) {
+			uint32_t sum = checksum (0, h, sizeof *h);
+			for (size_t i = 0; i < h->cnt; i++) {
+				disk_read (filesys_disk, journal_start + 1 + i, buf);
+				sum = checksum (sum, buf, DISK_SECTOR_SIZE);
+			}
+			disk_read (filesys_disk, journal_start + 1 + h->cnt, c);
+			// commit record까지 온전한 transaction만 다시 씀
+			if (c->magic == COMMIT_MAGIC && c->seq == h->seq
+					&& c->checksum == sum) {
+				for (size_t i = 0; i < h->cnt; i++) {
+					disk_read (filesys_disk, journal_start + 1 + i, buf);
+					disk_write (filesys_disk, h->sectors[i], buf);
+					replay_cnt++;
+				}
+			}
+		}
+		if (h->cnt > 0)
+			write_empty ();
+	}
+	// -journal-crash로 포맷을 마쳤으면 남은 transaction은 방금 제자리에 씀
+	lock_acquire (&txn_lock);
+	txn_len = 0;
+	lock_release (&txn_lock);
+	free (buf);
+	free (c);
+	free (h);
+}
+
+/* Prints journal statistics. */
+void
+journal_print_stats (void) {
+	printf ("Journal: %lld operations, %lld transactions, "
+			"%lld sectors logged, %lld sectors replayed\n",
+			op_total, txn_cnt, logged_cnt, replay_cnt);
+}
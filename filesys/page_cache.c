@@ -1,9 +1,72 @@
-/* page_cache.c: Implementation of Page Cache (Buffer Cache). */
+/* page_cache.c: Implementation of Page Cache (Buffer Cache).
+ *
+ * Every byte of file data that is in memory lives in exactly one cache
+ * page, found through the inode's hash by page-aligned offset.
+ * inode_read_at() and inode_write_at() copy to and from these pages, and
+ * a file mapping maps them directly as VM_PAGE_CACHE pages, so read(),
+ * write() and mmap always see the same data and a page that was just
+ * read can be mapped without touching the disk.
+ *
+ * Cache pages are written back lazily: by the kworkerd thread every
+ * PAGE_CACHE_FLUSH_INTERVAL ticks, by msync and munmap, when they are
+ * evicted, when the last opener closes the inode and at shutdown.
+ * kworkerd writes the dirty sectors of the buffer cache behind in the
+ * same pass, frees the clusters of removed files, records in the FAT
+ * which clusters have been written, and every JOURNAL_COMMIT_RUNS runs
+ * commits the metadata changed in between to the journal.
+ *
+ * A read that moves on to the page after the one read last queues the
+ * page after that for the readahead thread, so a sequential reader finds
+ * each page in the cache by the time it gets there.  The
+ * dirty bits of mapped pages are in the page tables of the processes
+ * mapping them and are gathered at those points.
+ *
+ * The cache keeps up to PAGE_CACHE_MAX pages nobody maps, evicting the
+ * least recently used one to make room.  Mapped pages may go beyond
+ * that; under memory pressure vm_get_frame() calls page_cache_reclaim(),
+ * which also takes mapped pages whose mappings were not used since the
+ * last look, unmapping them from every process.
+ *
+ * cache_lock is not held across disk I/O.  A page being read in or
+ * written back is marked busy first; it stays in the cache meanwhile, and
+ * anyone else who wants it waits on cache_io_done and looks it up again,
+ * while other pages can be used as usual. */
 
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <string.h>
 #include "vm/vm.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "filesys/page_cache.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/process.h"
+
+/* Unmapped pages kept in the cache. */
+#define PAGE_CACHE_MAX 128
+/* Ticks between two runs of the writeback worker. */
+#define PAGE_CACHE_FLUSH_INTERVAL TIMER_FREQ
+/* Runs of the writeback worker between two journal commits. */
+#define JOURNAL_COMMIT_RUNS 5
+/* Pages queued for the readahead thread at most; more are not read
+ * ahead. */
+#define READAHEAD_MAX 16
+
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
+static void page_cache_kworkerd (void *aux);
+static void page_cache_readaheadd (void *aux);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations page_cache_op = {
@@ -13,38 +76,699 @@ static const struct page_operations page_cache_op = {
 	.type = VM_PAGE_CACHE,
 };
 
+/* A page of file data. */
+struct cache_page {
+	struct frame frame;             /* frame.shared: not in the frame table. */
+	struct inode *inode;            /* File the data belongs to. */
+	off_t offset;                   /* Page-aligned offset in the file. */
+	bool dirty;                     /* Newer than the disk. */
+	bool busy;                      /* Being read or written; see above. */
+	uint64_t flush_gen;             /* Last flush that looked at it. */
+	struct list mappings;           /* VM_PAGE_CACHE pages mapping it. */
+	struct hash_elem elem;          /* Element in the inode's cache. */
+	struct list_elem lru_elem;      /* Element in lru_list. */
+};
+
 tid_t page_cache_workerd;
 
+/* Protects every inode's cache, the cache pages and their mappings. */
+static struct lock cache_lock;
+/* All cache pages, least recently used first. */
+static struct list lru_list;
+static size_t cache_cnt;
+/* Signaled, with cache_lock, whenever a page stops being busy. */
+static struct condition cache_io_done;
+/* Number of the last flush started; see cache_flush(). */
+static uint64_t flush_gen;
+
+/* 통계: 캐시에서 찾은 페이지 / 디스크에서 읽은 페이지 / 매핑으로 연결한 fault /
+ * 백그라운드로 쓴 페이지 / 쫓아낸 페이지 */
+static long long hit_cnt;
+static long long miss_cnt;
+static long long map_cnt;
+static long long flush_cnt;
+static long long evict_cnt;
+static long long readahead_cnt;
+
+/* A page for the readahead thread to bring in. */
+struct readahead_req {
+	struct inode *inode;            /* Reopened; closed when done. */
+	off_t offset;
+	struct list_elem elem;
+};
+
+// readahead thread가 처리할 요청. cache_lock으로 보호
+static struct list readahead_queue;
+static size_t readahead_queued;
+static struct condition readahead_ready;
+
+static uint64_t
+cache_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct cache_page *cp = hash_entry (e, struct cache_page, elem);
+	return hash_int (cp->offset);
+}
+
+static bool
+cache_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct cache_page *a = hash_entry (a_, struct cache_page, elem);
+	const struct cache_page *b = hash_entry (b_, struct cache_page, elem);
+	return a->offset < b->offset;
+}
+
+/* Initializes the page cache and starts its worker.  Called from
+ * inode_init(), since the file system uses the cache from the start. */
+void
+page_cache_init (void) {
+	lock_init (&cache_lock);
+	list_init (&lru_list);
+	cond_init (&cache_io_done);
+	list_init (&readahead_queue);
+	cond_init (&readahead_ready);
+	page_cache_workerd = thread_create ("kworkerd", PRI_DEFAULT,
+			page_cache_kworkerd, NULL);
+	thread_create ("readahead", PRI_DEFAULT, page_cache_readaheadd, NULL);
+}
+
 /* The initializer of file vm */
 void
 pagecache_init (void) {
-	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+	/* The cache is up before the VM: page_cache_init() runs from
+	 * filesys_init().  Nothing is left to do here. */
+}
+
+/* Gives newly opened INODE an empty cache. */
+void
+page_cache_open (struct inode *inode) {
+	hash_init (&inode->cache, cache_hash, cache_less, NULL);
+	inode->ra_next = 0;
+}
+
+/* Returns the number of bytes of file data in the page at OFFSET. */
+static off_t
+cache_page_bytes (struct cache_page *cp) {
+	off_t left = inode_length (cp->inode) - cp->offset;
+	return left < 0 ? 0 : left < PGSIZE ? left : PGSIZE;
+}
+
+/* Moves the dirty bits of CP's mappings into CP.  The bits are cleared,
+ * so a store that races with the writeback sets them again. */
+static void
+cache_gather_dirty (struct cache_page *cp) {
+	for (struct list_elem *e = list_begin (&cp->mappings);
+			e != list_end (&cp->mappings); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, page_cache.map_elem);
+		uint64_t *pml4 = page->owner->pml4;
+		if (pml4 != NULL && pml4_is_dirty (pml4, page->va)) {
+			pml4_set_dirty (pml4, page->va, false);
+			cp->dirty = true;
+		}
+	}
+}
+
+/* Marks CP, which is not busy, busy and releases cache_lock for disk
+ * I/O on it. */
+static void
+cache_io_begin (struct cache_page *cp) {
+	ASSERT (!cp->busy);
+	cp->busy = true;
+	lock_release (&cache_lock);
+}
+
+/* Reacquires cache_lock after disk I/O on CP and wakes up the threads
+ * waiting for it. */
+static void
+cache_io_end (struct cache_page *cp) {
+	lock_acquire (&cache_lock);
+	cp->busy = false;
+	cond_broadcast (&cache_io_done, &cache_lock);
+}
+
+/* Writes CP, which is not busy, back if it or one of its mappings is
+ * dirty.  Returns true if it was written.  Releases cache_lock during
+ * the write; CP stays in the cache meanwhile. */
+static bool
+cache_writeback (struct cache_page *cp) {
+	cache_gather_dirty (cp);
+	if (!cp->dirty)
+		return false;
+
+	cp->dirty = false;
+	// 지워진 파일은 close 때 블록이 반납되므로 쓸 필요 없음
+	if (cp->inode->removed)
+		return false;
+	off_t bytes = cache_page_bytes (cp);
+	if (bytes > 0) {
+		cache_io_begin (cp);
+		inode_write_sectors (cp->inode, cp->frame.kva, bytes, cp->offset);
+		cache_io_end (cp);
+	}
+	return true;
+}
+
+/* Detaches PAGE from the cache page it maps, carrying its dirty bit
+ * over.  The entry is only marked not present, as pml4_clear_page()
+ * does, so a later fault maps the page again. */
+static void
+cache_unmap (struct page *page) {
+	struct cache_page *cp = page->page_cache.cp;
+	uint64_t *pml4 = page->owner->pml4;
+
+	if (cp == NULL)
+		return;
+	if (pml4 != NULL) {
+		pml4_clear_page (pml4, page->va);
+		if (pml4_is_dirty (pml4, page->va))
+			cp->dirty = true;
+	}
+	list_remove (&page->page_cache.map_elem);
+	page->page_cache.cp = NULL;
+	page->frame = NULL;
+}
+
+/* Returns true if a mapping of CP was used since the last call, and
+ * clears the accessed bits for the next one. */
+static bool
+cache_referenced (struct cache_page *cp) {
+	bool referenced = false;
+
+	for (struct list_elem *e = list_begin (&cp->mappings);
+			e != list_end (&cp->mappings); e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, page_cache.map_elem);
+		uint64_t *pml4 = page->owner->pml4;
+		if (pml4 != NULL && pml4_is_accessed (pml4, page->va)) {
+			pml4_set_accessed (pml4, page->va, false);
+			referenced = true;
+		}
+	}
+	return referenced;
+}
+
+/* Unmaps CP, which is not busy, everywhere, writes it back if needed
+ * and takes it out of the cache.  Returns its memory, which the caller
+ * now owns.  May release cache_lock for a while, like cache_writeback(). */
+static void *
+cache_release (struct cache_page *cp) {
+	void *kva = cp->frame.kva;
+
+	while (!list_empty (&cp->mappings))
+		cache_unmap (list_entry (list_front (&cp->mappings), struct page,
+					page_cache.map_elem));
+	cache_writeback (cp);
+	hash_delete (&cp->inode->cache, &cp->elem);
+	list_remove (&cp->lru_elem);
+	free (cp);
+	cache_cnt--;
+	return kva;
+}
+
+/* Evicts the least recently used cache page and returns its memory.
+ * Busy pages are passed over, and so are mapped pages unless MAPPED, and
+ * even then they get a second chance if one of their mappings was used.
+ * Returns NULL if there is nothing to evict. */
+static void *
+cache_evict (bool mapped) {
+	for (size_t i = 0; i < 2 * cache_cnt; i++) {
+		struct cache_page *cp = list_entry (list_front (&lru_list),
+				struct cache_page, lru_elem);
+		if (cp->busy || (!list_empty (&cp->mappings)
+					&& (!mapped || cache_referenced (cp)))) {
+			list_remove (&cp->lru_elem);
+			list_push_back (&lru_list, &cp->lru_elem);
+			continue;
+		}
+		evict_cnt++;
+		return cache_release (cp);
+	}
+	return NULL;
+}
+
+/* Returns memory for a new cache page, evicting a page if the cache is
+ * full or there is no free page, or NULL if none is available.  May
+ * release cache_lock for a while, like cache_writeback(). */
+static void *
+cache_alloc (void) {
+	void *kva = NULL;
+
+	if (cache_cnt >= PAGE_CACHE_MAX)
+		kva = cache_evict (false);
+	if (kva == NULL)
+		kva = palloc_get_page (PAL_USER);
+	if (kva == NULL)
+		kva = cache_evict (true);
+	return kva;
+}
+
+/* Returns the cache page that holds INODE's data at OFFSET, a multiple
+ * of PGSIZE, and marks it most recently used.  On a miss the page is
+ * read from disk, unless FILL is false because the caller is about to
+ * overwrite all of its data.  Returns NULL if no memory is available.
+ * Caller holds cache_lock, which is released while waiting for a busy
+ * page and during disk I/O; the page returned is not busy. */
+static struct cache_page *
+cache_get (struct inode *inode, off_t offset, bool fill) {
+	struct cache_page key;
+	struct cache_page *cp;
+	void *kva = NULL;
+
+	key.offset = offset;
+	for (;;) {
+		struct hash_elem *e = hash_find (&inode->cache, &key.elem);
+		if (e != NULL) {
+			cp = hash_entry (e, struct cache_page, elem);
+			// 다른 스레드가 읽거나 쓰는 중이면 끝난 뒤 다시 찾음. 그사이 쫓겨났을 수 있음
+			if (cp->busy) {
+				cond_wait (&cache_io_done, &cache_lock);
+				continue;
+			}
+			if (kva != NULL)
+				palloc_free_page (kva);
+			list_remove (&cp->lru_elem);
+			list_push_back (&lru_list, &cp->lru_elem);
+			hit_cnt++;
+			return cp;
+		}
+		if (kva != NULL)
+			break;
+		// 쫓아낸 페이지를 쓰는 동안 lock을 놓으므로 그사이 누가 넣었는지 다시 확인
+		kva = cache_alloc ();
+		if (kva == NULL)
+			return NULL;
+	}
+
+	cp = malloc (sizeof *cp);
+	if (cp == NULL) {
+		palloc_free_page (kva);
+		return NULL;
+	}
+	cp->frame.kva = kva;
+	cp->frame.page = NULL;
+	cp->frame.shared = true;
+	cp->frame.pinned = false;
+	cp->inode = inode;
+	cp->offset = offset;
+	cp->dirty = false;
+	cp->busy = false;
+	cp->flush_gen = 0;
+	list_init (&cp->mappings);
+
+	off_t bytes = fill ? cache_page_bytes (cp) : 0;
+	memset (kva + bytes, 0, PGSIZE - bytes);
+	hash_insert (&inode->cache, &cp->elem);
+	list_push_back (&lru_list, &cp->lru_elem);
+	cache_cnt++;
+	miss_cnt++;
+	if (bytes == 0)
+		return cp;
+
+	// 읽는 동안에도 페이지는 캐시에 있어서 같은 페이지를 찾는 스레드는 기다림
+	cache_io_begin (cp);
+	bool success = inode_read_sectors (inode, kva, bytes, offset) == bytes;
+	cache_io_end (cp);
+	if (!success) {
+		hash_delete (&inode->cache, &cp->elem);
+		list_remove (&cp->lru_elem);
+		cache_cnt--;
+		palloc_free_page (kva);
+		free (cp);
+		return NULL;
+	}
+	return cp;
+}
+
+/* Queues INODE's page at OFFSET for the readahead thread unless it is
+ * past the end of the file, cached already or the queue is full.  Caller
+ * holds cache_lock. */
+static void
+cache_readahead (struct inode *inode, off_t offset) {
+	struct cache_page key;
+	key.offset = offset;
+
+	// readahead thread가 밀려 있으면 미리 읽기는 버림. 읽는 쪽이 직접 읽으면 됨
+	if (readahead_queued >= READAHEAD_MAX || offset >= inode_length (inode)
+			|| hash_find (&inode->cache, &key.elem) != NULL)
+		return;
+	struct readahead_req *req = malloc (sizeof *req);
+	if (req == NULL)
+		return;
+	req->inode = inode_reopen (inode);
+	req->offset = offset;
+	list_push_back (&readahead_queue, &req->elem);
+	readahead_queued++;
+	cond_signal (&readahead_ready, &cache_lock);
+}
+
+/* Copies SIZE bytes at OFFSET in INODE, which do not cross a page
+ * boundary, into BUFFER.  Returns false if the page could not be
+ * cached; the caller then reads the disk directly. */
+bool
+page_cache_read (struct inode *inode, void *buffer, off_t size,
+		off_t offset) {
+	ASSERT (offset % PGSIZE + size <= PGSIZE);
+
+	off_t page_ofs = offset - offset % PGSIZE;
+
+	lock_acquire (&cache_lock);
+	struct cache_page *cp = cache_get (inode, page_ofs, true);
+	if (cp != NULL)
+		memcpy (buffer, cp->frame.kva + pg_ofs (offset), size);
+	// 바로 다음 페이지로 넘어왔으면 순차 읽기로 보고 그다음 페이지를 미리 읽음
+	if (page_ofs == inode->ra_next)
+		cache_readahead (inode, page_ofs + PGSIZE);
+	if (page_ofs + PGSIZE != inode->ra_next)
+		inode->ra_next = page_ofs + PGSIZE;
+	lock_release (&cache_lock);
+	return cp != NULL;
+}
+
+/* Brings INODE's page at OFFSET, a multiple of PGSIZE, into the cache
+ * without copying it anywhere, for launch prefetch.  Returns true if it
+ * had to be read from disk. */
+bool
+page_cache_prefetch (struct inode *inode, off_t offset) {
+	ASSERT (offset % PGSIZE == 0);
+
+	if (offset >= inode_length (inode))
+		return false;
+	lock_acquire (&cache_lock);
+	long long misses = miss_cnt;
+	struct cache_page *cp = cache_get (inode, offset, true);
+	bool read = cp != NULL && miss_cnt != misses;
+	lock_release (&cache_lock);
+	return read;
+}
+
+/* Copies SIZE bytes from BUFFER to OFFSET in INODE, which do not cross a
+ * page boundary, and marks the page dirty.  Returns false if the page
+ * could not be cached; the caller then writes the disk directly. */
+bool
+page_cache_write (struct inode *inode, const void *buffer, off_t size,
+		off_t offset) {
+	ASSERT (offset % PGSIZE + size <= PGSIZE);
+
+	off_t page_ofs = offset - offset % PGSIZE;
+	off_t left = inode_length (inode) - page_ofs;
+	// 페이지 안의 파일 데이터를 전부 덮어쓰면 디스크에서 읽을 필요가 없음
+	bool fill = !(offset == page_ofs && size >= (left < PGSIZE ? left : PGSIZE));
+
+	lock_acquire (&cache_lock);
+	struct cache_page *cp = cache_get (inode, page_ofs, fill);
+	if (cp != NULL) {
+		memcpy (cp->frame.kva + pg_ofs (offset), buffer, size);
+		cp->dirty = true;
+	}
+	lock_release (&cache_lock);
+	return cp != NULL;
+}
+
+/* Writes back and drops every cached page of INODE, whose last opener
+ * is closing it.  No mapping can be left, since each holds the file
+ * open. */
+void
+page_cache_close (struct inode *inode) {
+	struct hash_iterator i;
+
+	lock_acquire (&cache_lock);
+	hash_first (&i, &inode->cache);
+	while (hash_next (&i)) {
+		struct cache_page *cp = hash_entry (hash_cur (&i), struct cache_page,
+				elem);
+		// 쫓아내느라 쓰고 있는 페이지는 끝나면 캐시에서 빠짐
+		if (cp->busy)
+			cond_wait (&cache_io_done, &cache_lock);
+		else {
+			ASSERT (list_empty (&cp->mappings));
+			palloc_free_page (cache_release (cp));
+		}
+		// 삭제나 lock을 놓은 사이의 변경은 iterator를 무효화하므로 처음부터 다시
+		hash_first (&i, &inode->cache);
+	}
+	lock_release (&cache_lock);
+	hash_destroy (&inode->cache, NULL);
+}
+
+/* Drops every cached page of INODE without writing it back, because its
+ * data has moved to other clusters (see inode_replace_data()).  Pages
+ * being read or written are waited for first.  Only directories have
+ * their data moved, and they are never mapped. */
+void
+page_cache_drop (struct inode *inode) {
+	struct hash_iterator i;
+
+	lock_acquire (&cache_lock);
+	hash_first (&i, &inode->cache);
+	while (hash_next (&i)) {
+		struct cache_page *cp = hash_entry (hash_cur (&i), struct cache_page,
+				elem);
+		if (cp->busy)
+			cond_wait (&cache_io_done, &cache_lock);
+		else {
+			ASSERT (list_empty (&cp->mappings));
+			hash_delete (&inode->cache, &cp->elem);
+			list_remove (&cp->lru_elem);
+			palloc_free_page (cp->frame.kva);
+			free (cp);
+			cache_cnt--;
+		}
+		hash_first (&i, &inode->cache);
+	}
+	lock_release (&cache_lock);
+}
+
+/* Returns true if CP was looked at by flush GEN or a later one, and
+ * otherwise marks it as looked at. */
+static bool
+cache_flush_seen (struct cache_page *cp, uint64_t gen) {
+	if (cp->flush_gen >= gen)
+		return true;
+	cp->flush_gen = gen;
+	return false;
+}
+
+/* Writes back every dirty cache page that is not busy.  Returns the
+ * number written.  Caller holds cache_lock, which is released during
+ * each write.
+ *
+ * Meanwhile cache_evict() and cache_get() may move pages, including the
+ * one being written, to the end of lru_list, so the walk starts over
+ * after each write and skips the pages this flush has already looked
+ * at. */
+static long long
+cache_flush (void) {
+	uint64_t gen = ++flush_gen;
+	long long written = 0;
+	struct list_elem *e = list_begin (&lru_list);
+
+	while (e != list_end (&lru_list)) {
+		struct cache_page *cp = list_entry (e, struct cache_page, lru_elem);
+		if (cp->busy || cache_flush_seen (cp, gen))
+			e = list_next (e);
+		else {
+			if (cache_writeback (cp))
+				written++;
+			e = list_begin (&lru_list);
+		}
+	}
+	return written;
+}
+
+/* Writes back every dirty cache page, e.g. at shutdown. */
+void
+page_cache_flush_all (void) {
+	lock_acquire (&cache_lock);
+	cache_flush ();
+	lock_release (&cache_lock);
+}
+
+/* Writes back every dirty directory page, waiting for those that are
+ * busy, so that the running journal transaction has all of them. */
+void
+page_cache_flush_dirs (void) {
+	lock_acquire (&cache_lock);
+	uint64_t gen = ++flush_gen;
+	struct list_elem *e = list_begin (&lru_list);
+	while (e != list_end (&lru_list)) {
+		struct cache_page *cp = list_entry (e, struct cache_page, lru_elem);
+		if (!inode_isdir (cp->inode))
+			e = list_next (e);
+		else if (cp->busy) {
+			// 다른 flush가 살펴봤어도 아직 쓰는 중이므로 끝날 때까지 기다린 뒤 처음부터 다시
+			cond_wait (&cache_io_done, &cache_lock);
+			e = list_begin (&lru_list);
+		} else if (cache_flush_seen (cp, gen))
+			e = list_next (e);
+		else {
+			// 쓰는 동안 목록 순서가 바뀔 수 있으므로 cache_flush()처럼 처음부터 다시
+			if (cache_writeback (cp))
+				flush_cnt++;
+			e = list_begin (&lru_list);
+		}
+	}
+	lock_release (&cache_lock);
+}
+
+/* Returns how many sectors of directory pages are dirty, or busy and so
+ * possibly being written back. */
+size_t
+page_cache_dirty_dirs (void) {
+	size_t cnt = 0;
+
+	lock_acquire (&cache_lock);
+	for (struct list_elem *e = list_begin (&lru_list); e != list_end (&lru_list);
+			e = list_next (e)) {
+		struct cache_page *cp = list_entry (e, struct cache_page, lru_elem);
+		if (inode_isdir (cp->inode) && (cp->dirty || cp->busy))
+			cnt += PGSIZE / DISK_SECTOR_SIZE;
+	}
+	lock_release (&cache_lock);
+	return cnt;
+}
+
+/* Gives one cache page back to palloc, unmapping it if it has to.
+ * Returns false if the cache is empty. */
+bool
+page_cache_reclaim (void) {
+	lock_acquire (&cache_lock);
+	void *kva = cache_evict (true);
+	lock_release (&cache_lock);
+
+	if (kva != NULL)
+		palloc_free_page (kva);
+	return kva != NULL;
 }
 
 /* Initialize the page cache */
 bool
-page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
+page_cache_initializer (struct page *page, enum vm_type type UNUSED,
+		void *kva UNUSED) {
+	/* Fetch first; page_cache overlaps the uninit data. */
+	struct container *aux = page->uninit.aux;
+	struct file *file = aux->file;
+	off_t offset = aux->offset;
+
 	/* Set up the handler */
 	page->operations = &page_cache_op;
+	page->page_cache.file = file;
+	page->page_cache.offset = offset;
+	page->page_cache.cp = NULL;
+	return true;
+}
 
+/* Maps PAGE, a VM_PAGE_CACHE page of a file mapping, to its cache page,
+ * reading it in if it is not cached yet.  Unlike other page types no
+ * frame of its own is allocated. */
+bool
+page_cache_map (struct page *page) {
+	if (VM_TYPE (page->operations->type) == VM_UNINIT
+			&& !page->uninit.page_initializer (page, page->uninit.type, NULL))
+		return false;
+	return swap_in (page, NULL);
 }
 
-/* Utilze the Swap in mechanism to implement readhead */
+/* Looks up PAGE's cache page, reading it from the file on a miss, and
+ * maps it.  KVA is unused: the mapping shares the cache page. */
 static bool
-page_cache_readahead (struct page *page, void *kva) {
+page_cache_readahead (struct page *page, void *kva UNUSED) {
+	struct page_cache *pc = &page->page_cache;
+
+	lock_acquire (&cache_lock);
+	if (pc->cp == NULL) {
+		struct cache_page *cp = cache_get (file_get_inode (pc->file),
+				pc->offset, true);
+		if (cp == NULL) {
+			lock_release (&cache_lock);
+			return false;
+		}
+		list_push_back (&cp->mappings, &pc->map_elem);
+		pc->cp = cp;
+		page->frame = &cp->frame;
+		map_cnt++;
+	}
+	bool success = pml4_set_page (page->owner->pml4, page->va,
+			pc->cp->frame.kva, page->writable);
+	lock_release (&cache_lock);
+	return success;
 }
 
-/* Utilze the Swap out mechanism to implement writeback */
+/* Unmaps PAGE from its cache page.  The data stays in the cache, dirty
+ * if PAGE wrote to it, for the cache to write back later. */
 static bool
 page_cache_writeback (struct page *page) {
+	lock_acquire (&cache_lock);
+	cache_unmap (page);
+	lock_release (&cache_lock);
+	return true;
+}
+
+/* Writes PAGE's cache page back to the file now if it is dirty, for
+ * msync.  Returns the number of pages written. */
+int
+page_cache_sync (struct page *page) {
+	int written = 0;
+
+	if (VM_TYPE (page->operations->type) != VM_PAGE_CACHE)
+		return 0;
+	lock_acquire (&cache_lock);
+	// kworkerd가 쓰고 있으면 그 뒤에 바뀐 내용만 다시 씀
+	while (page->page_cache.cp != NULL && page->page_cache.cp->busy)
+		cond_wait (&cache_io_done, &cache_lock);
+	if (page->page_cache.cp != NULL && cache_writeback (page->page_cache.cp))
+		written = 1;
+	lock_release (&cache_lock);
+	return written;
 }
 
 /* Destory the page_cache. */
 static void
 page_cache_destroy (struct page *page) {
+	page_cache_writeback (page);
+}
+
+/* Prints page cache statistics. */
+void
+page_cache_print_stats (void) {
+	printf ("Page cache: %lld hits, %lld misses, %lld mapped faults, "
+			"%lld pages written back in background, %lld evicted, "
+			"%lld read ahead\n",
+			hit_cnt, miss_cnt, map_cnt, flush_cnt, evict_cnt, readahead_cnt);
 }
 
 /* Worker thread for page cache */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_kworkerd (void *aux UNUSED) {
+	for (int run = 1; ; run++) {
+		timer_sleep (PAGE_CACHE_FLUSH_INTERVAL);
+		lock_acquire (&cache_lock);
+		flush_cnt += cache_flush ();
+		lock_release (&cache_lock);
+		// 페이지를 쓰면서 생긴 부분 섹터까지 함께 내려보냄
+		buffer_cache_flush ();
+		// 둘 다 한 operation에 넣기엔 클 수 있어 여기서 나눠서 함
+		inode_free_chains ();
+#ifdef EFILESYS
+		fat_sync_written ();
+#endif
+		// metadata는 몇 초 동안 바뀐 것을 operation 사이에서 한 transaction으로 씀
+		if (run % JOURNAL_COMMIT_RUNS == 0)
+			journal_commit ();
+	}
+}
+
+/* Reads queued pages into the cache ahead of sequential readers. */
+static void
+page_cache_readaheadd (void *aux UNUSED) {
+	for (;;) {
+		lock_acquire (&cache_lock);
+		while (list_empty (&readahead_queue))
+			cond_wait (&readahead_ready, &cache_lock);
+		struct readahead_req *req = list_entry (list_pop_front (&readahead_queue),
+				struct readahead_req, elem);
+		readahead_queued--;
+		lock_release (&cache_lock);
+
+		if (page_cache_prefetch (req->inode, req->offset))
+			readahead_cnt++;
+		inode_close (req->inode);
+		free (req);
+	}
 }
@@ -0,0 +1,16 @@
+#ifndef FILESYS_BUFFER_CACHE_H
+#define FILESYS_BUFFER_CACHE_H
+#include "devices/disk.h"
+
+void buffer_cache_init (void);
+void buffer_cache_read (disk_sector_t sector, void *buffer, int ofs, int size);
+void buffer_cache_write (disk_sector_t sector, const void *buffer, int ofs,
+		int size);
+void buffer_cache_write_meta (disk_sector_t sector, const void *buffer,
+		int ofs, int size);
+void buffer_cache_read_through (disk_sector_t sector, void *buffer);
+void buffer_cache_write_through (disk_sector_t sector, const void *buffer);
+void buffer_cache_zero (disk_sector_t sector);
+void buffer_cache_flush (void);
+void buffer_cache_print_stats (void);
+#endif
@@ -0,0 +1,16 @@
+#ifndef FILESYS_DCACHE_H
+#define FILESYS_DCACHE_H
+#include <stdbool.h>
+#include "devices/disk.h"
+
+struct dir_entry;
+
+void dcache_init (void);
+bool dcache_lookup (disk_sector_t dir, const char *name, struct dir_entry *ep,
+		bool *found);
+void dcache_insert (disk_sector_t dir, const char *name,
+		const struct dir_entry *e);
+void dcache_invalidate (disk_sector_t dir, const char *name);
+void dcache_purge_dir (disk_sector_t dir);
+void dcache_print_stats (void);
+#endif
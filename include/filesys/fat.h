@@ -28,15 +28,25 @@ void fat_close (void);
 cluster_t fat_create_chain (
     cluster_t clst /* Cluster # to stretch, 0: Create a new chain */
 );
+cluster_t fat_extend_chain (cluster_t clst, size_t cnt, bool unwritten);
+cluster_t fat_create_run (size_t cnt);
 void fat_remove_chain (
     cluster_t clst, /* Cluster # to be removed */
     cluster_t pclst /* Previous cluster of clst, 0: clst is the start of chain */
 );
+cluster_t fat_remove_run (cluster_t clst, cluster_t pclst, size_t cnt);
 cluster_t fat_get (cluster_t clst);
 void fat_put (cluster_t clst, cluster_t val);
+bool fat_unwritten (cluster_t clst);
+void fat_set_written (cluster_t clst);
+void fat_sync_written (void);
 disk_sector_t cluster_to_sector (cluster_t clst);
 cluster_t sector_to_cluster (disk_sector_t sector);
 
 void init_fat_bitmap(void);
+void fat_flush (void);
+void fat_release (void);
+size_t fat_dirty_count (void);
+void fat_print_stats (void);
 
 #endif /* filesys/fat.h */
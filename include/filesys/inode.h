@@ -5,9 +5,12 @@
 #include "filesys/off_t.h"
 #include "devices/disk.h"
 
+#include <hash.h>
 #include <list.h>
+#include "threads/synch.h"
 
 struct bitmap;
+struct cluster_map;
 
 struct inode_disk {
 	disk_sector_t start;                /* First data sector. */
@@ -15,17 +18,25 @@ struct inode_disk {
 	unsigned magic;                     /* Magic number. */
 	//project 4-2
 	bool isdir;
-	uint8_t unused [499];				/* Not used. */
+	bool dir_hashed;                    /* Entries placed by name hash. */
+	uint32_t dir_used;                  /* Hashed: slots ever used. */
+	uint8_t unused [492];				/* Not used. */
 };
 
 // In-memory inode. 
 struct inode {
-    struct list_elem elem;
+    struct hash_elem table_elem;    /* Element in the inode table. */
+    struct list_elem elem;          /* Element in the closed inode list. */
     disk_sector_t sector;
     int open_cnt;
     bool removed;
     int deny_write_cnt;
     struct inode_disk data;
+    bool dirty;                     /* DATA changed since written back. */
+    struct hash cache;              /* Cached pages of data, by offset (filesys/page_cache.c). */
+    off_t ra_next;                  /* Page a sequential reader reads next. */
+    struct cluster_map *map;        /* Clusters of the data found so far, or NULL. */
+    struct lock dir_lock;           /* Directory: orders entry changes and dentry cache fills (filesys/directory.c). */
 };
 
 void inode_init (void);
@@ -37,10 +48,23 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_read_sectors (struct inode *, void *, off_t size, off_t offset);
+off_t inode_write_sectors (struct inode *, const void *, off_t size,
+		off_t offset);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
+bool inode_extend (struct inode *, off_t length);
+void inode_flush_all (void);
+void inode_free_chains (void);
+size_t inode_dirty_count (void);
+void inode_print_stats (void);
 
 bool inode_isdir (struct inode *);
+bool inode_dir_hashed (const struct inode *);
+size_t inode_dir_used (const struct inode *);
+void inode_set_dir_index (struct inode *, bool hashed, size_t used);
+bool inode_replace_data (struct inode *, disk_sector_t start, size_t cnt,
+		off_t length);
 
 #endif /* filesys/inode.h */
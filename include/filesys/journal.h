@@ -0,0 +1,36 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices/disk.h"
+
+/* Most sectors one transaction logs.  The journal area needs two
+ * sectors more, for the header and the commit record. */
+#define JOURNAL_TXN_MAX 120
+#define JOURNAL_SECTORS (JOURNAL_TXN_MAX + 2)
+
+/* Most metadata sectors one operation between journal_begin() and
+ * journal_end() may change.  Making a directory is the largest: the FAT
+ * sectors of its inode and first cluster (2), its inode (1), its first
+ * page (8), then in the parent the two pages a new entry may straddle
+ * (16), its inode (1) and, if the parent is rebuilt, the FAT sectors of
+ * the new table and of the link to it (11).  Work that could change more
+ * is split into operations of its own. */
+#define JOURNAL_OP_SECTORS 40
+
+/* -journal-crash: power off without writing the last transaction in
+ * place. */
+extern bool journal_crash;
+
+void journal_init (void);
+void journal_open (disk_sector_t start, size_t sectors);
+bool journal_enabled (void);
+void journal_begin (void);
+void journal_end (void);
+void journal_add (disk_sector_t sector, const void *image);
+bool journal_read (disk_sector_t sector, void *buffer);
+void journal_commit (void);
+bool journal_close (void);
+void journal_recover (void);
+void journal_print_stats (void);
+#endif
@@ -1,12 +1,41 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <stdbool.h>
+#include <list.h>
+#include "filesys/off_t.h"
 
 struct page;
 enum vm_type;
+struct inode;
+struct file;
+struct cache_page;
 
-struct page_cache {};
+/* A user page of type VM_PAGE_CACHE: a page of a file mapping that maps
+ * the file's cache page itself instead of a private copy. */
+struct page_cache {
+	struct file *file;              /* Mapped file. */
+	off_t offset;                   /* Page-aligned offset in FILE. */
+	struct cache_page *cp;          /* Cache page mapped, or NULL. */
+	struct list_elem map_elem;      /* Element in CP's list of mappings. */
+};
 
 void page_cache_init (void);
+void pagecache_init (void);
+void page_cache_open (struct inode *inode);
+void page_cache_close (struct inode *inode);
+void page_cache_drop (struct inode *inode);
+bool page_cache_read (struct inode *inode, void *buffer, off_t size,
+		off_t offset);
+bool page_cache_write (struct inode *inode, const void *buffer, off_t size,
+		off_t offset);
+bool page_cache_prefetch (struct inode *inode, off_t offset);
+void page_cache_flush_all (void);
+void page_cache_flush_dirs (void);
+size_t page_cache_dirty_dirs (void);
+void page_cache_print_stats (void);
+
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+bool page_cache_map (struct page *page);
+int page_cache_sync (struct page *page);
+bool page_cache_reclaim (void);
 #endif
@@ -0,0 +1,15 @@
+#ifndef __LIB_MMAN_H
+#define __LIB_MMAN_H
+
+/* Access pattern hints for madvise(). */
+#define MADV_NORMAL     0       /* No special treatment. */
+#define MADV_RANDOM     1       /* Random access: never read ahead. */
+#define MADV_SEQUENTIAL 2       /* Sequential access: read ahead, reclaim behind. */
+#define MADV_WILLNEED   3       /* Prefetch the range soon. */
+#define MADV_DONTNEED   4       /* Drop the range's frames and swap slots now. */
+
+/* Or'ed into mmap()'s WRITABLE argument: prefetch the whole mapping in
+   the background instead of faulting it in page by page. */
+#define MAP_POPULATE    0x100
+
+#endif /* lib/mman.h */
@@ -36,6 +36,12 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Virtual memory extensions. */
+	SYS_MSYNC,                  /* Write back dirty pages of a mapping. */
+	SYS_MADVISE,                /* Give access pattern hints for memory. */
+	SYS_SETRSS,                 /* Limit the resident set of the process. */
+	SYS_GETRSS,                 /* Report the resident set of the process. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -128,6 +128,12 @@ struct thread {
 	struct supplemental_page_table spt;
 	void *stack_bottom;
 	void *rsp_stack;
+	struct launch *launch;              /* Launch being traced (vm/launch.c). */
+	size_t rss;                         /* Private frames held (vm/vm.c). */
+	size_t rss_limit;                   /* Most frames to hold, 0 for none. */
+#endif
+#ifdef FILESYS
+	int journal_depth;                  /* Nested journal_begin() calls. */
 #endif
 #ifdef EFILESYS
 	struct dir *wd;
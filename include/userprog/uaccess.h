@@ -0,0 +1,25 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* 커널이 유저 메모리를 읽고 쓰는 함수들.
+ * 주소 범위가 유저 영역인지만 확인하고 바로 복사하며, 매핑되지 않은 페이지는
+ * page fault에서 처리(lazy load, stack growth, copy-on-write)된다.
+ * 처리할 수 없는 fault는 exception table을 통해 실패 값으로 돌아온다. */
+
+/* Exception table entry: a fault at INSN resumes at FIXUP. */
+struct exception_entry {
+	uint64_t insn;
+	uint64_t fixup;
+};
+
+bool user_range_ok (const void *uaddr, size_t size);
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+long strncpy_from_user (char *dst, const char *usrc, size_t size);
+void uaccess_print_stats (void);
+
+#endif /* userprog/uaccess.h */
@@ -0,0 +1,16 @@
+#ifndef VM_ADVISE_H
+#define VM_ADVISE_H
+#include <stdbool.h>
+#include <stddef.h>
+
+struct page;
+struct thread;
+
+void vm_advise_init (void);
+bool do_madvise (void *addr, size_t length, int advice);
+void advise_prefetch (void *addr, size_t length);
+void advise_fault (struct page *page);
+void advise_cancel (struct thread *owner);
+void advise_print_stats (void);
+
+#endif
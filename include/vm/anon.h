@@ -4,11 +4,20 @@
 struct page;
 enum vm_type;
 
+/* swap slot이 없는 페이지의 swap_index 값 */
+#define SWAP_SLOT_NONE -1
+
 struct anon_page {
     int swap_index;
 };
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_drop_stale_slot (struct page *page);
+void anon_print_stats (void);
+void swap_status (void);
+
+/* Swap areas from the -swap option, or NULL for hd1:1. */
+extern const char *swap_spec;
 
 #endif
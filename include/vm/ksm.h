@@ -0,0 +1,15 @@
+#ifndef VM_KSM_H
+#define VM_KSM_H
+#include <stddef.h>
+
+struct page;
+
+/* ksm thread가 한 번 깨어날 때 살펴보는 frame 수 (-ksm-pages 옵션).
+ * 0이면 thread를 띄우지 않음. */
+extern size_t ksm_pages_per_pass;
+
+void vm_ksm_init (void);
+void ksm_forget (struct page *page);
+void ksm_print_stats (void);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef VM_LAUNCH_H
+#define VM_LAUNCH_H
+#include "filesys/off_t.h"
+
+struct file;
+struct page;
+struct thread;
+
+void vm_launch_init (void);
+void launch_start (struct file *file);
+void launch_record (struct page *page, off_t offset);
+void launch_first_output (void);
+void launch_finish (struct thread *t);
+void launch_print_stats (void);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef VM_PAGEOUT_H
+#define VM_PAGEOUT_H
+#include <stddef.h>
+#include <stdint.h>
+
+/* 남은 user frame이 low 아래로 떨어지면 daemon이 깨어나 high까지 회수.
+ * low가 0이면 daemon을 띄우지 않음 (-pageout-low, -pageout-high 옵션). */
+extern size_t pageout_low_wm;
+extern size_t pageout_high_wm;
+
+void pageout_init (void);
+void pageout_wake (void);
+void pageout_count_direct (void);
+void pageout_record_fault (uint64_t cycles);
+void pageout_print_stats (void);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef VM_SHARED_H
+#define VM_SHARED_H
+#include "vm/vm.h"
+#include "filesys/off_t.h"
+
+struct page;
+struct inode;
+
+/* 여러 페이지가 read-only로 같이 매핑하는 frame.
+ * frame_table에 들어가지 않으므로 eviction 대상이 아니고 (text는 TEXT_FRAMES_MAX개까지),
+ * 마지막 페이지가 떨어져 나갈 때 반납된다. */
+struct shared_frame {
+	struct frame frame;             /* frame.shared == true, frame.page == NULL */
+	struct inode *inode;            /* Key: 실행 파일의 inode (참조를 하나 잡고 있음). ksm frame이면 NULL */
+	off_t offset;                   /* Key: 파일 안의 오프셋. ksm frame이면 내용 checksum */
+	size_t read_bytes;              /* Key: 파일에서 읽은 바이트 수. 나머지는 0. ksm frame이면 0 */
+	int ref_cnt;                    /* 이 frame을 매핑한 페이지 수 (읽기를 기다리는 fault 포함) */
+	bool loading;                   /* 첫 fault가 파일에서 읽는 중. text_loaded로 기다림 */
+	struct hash_elem elem;          /* shared_frames 해시 element */
+};
+
+void vm_shared_init (void);
+bool shared_claim_text (struct page *page);
+bool shared_map (struct page *page, struct frame *frame);
+bool shared_map_zero (struct page *page);
+bool shared_is_zero (const struct frame *frame);
+void shared_release (struct page *page);
+bool shared_ksm_merge (struct page *page, const void *kva, uint32_t checksum);
+bool shared_ksm_insert (struct page *page, void *kva, uint32_t checksum);
+void shared_print_stats (void);
+
+#endif
@@ -4,6 +4,7 @@
 #include "threads/palloc.h"
 #include "lib/kernel/hash.h"
 #include "threads/vaddr.h"
+#include "threads/synch.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -29,9 +30,7 @@ enum vm_type {
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
-#ifdef EFILESYS
 #include "filesys/page_cache.h"
-#endif
 
 struct page_operations;
 struct thread;
@@ -61,6 +60,11 @@ struct page {
 
     struct hash_elem hash_elem;		// 해시 테이블 element
 	int reference_cnt;
+	struct thread *owner;			// 이 페이지를 spt에 가지고 있는 프로세스 (pml4 접근용)
+	uint8_t advice;					// madvise로 받은 접근 패턴 (MADV_*, vm/advise.c)
+	bool ksm_candidate;				// 같은 내용 페이지를 찾는 후보 테이블에 있음 (vm/ksm.c)
+	uint32_t ksm_checksum;			// 후보 테이블에 넣을 때의 내용 checksum
+	struct hash_elem ksm_elem;		// 후보 테이블 element
 
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
@@ -68,9 +72,7 @@ struct page {
 		struct uninit_page uninit;
 		struct anon_page anon;
 		struct file_page file;
-#ifdef EFILESYS
 		struct page_cache page_cache;
-#endif
 	};
 };
 
@@ -79,6 +81,8 @@ struct frame {
 	void *kva;						// 커널의 가상 주소
 	struct page *page;				// 페이지 구조체
 	struct list_elem frame_elem;	// frame table 만들기 위해
+	bool shared;					// 여러 페이지가 공유하는 read-only frame (vm/shared.c)
+	bool pinned;					// 채우는 중이거나 쫓겨나는 중인 frame -> eviction 대상에서 제외
 };
 
 /* The function table for page operations.
@@ -103,6 +107,7 @@ struct page_operations {
 
 struct supplemental_page_table {
 	struct hash pages;
+	struct lock lock;		/* 페이지 claim과 hash 수정을 prefetch worker와 직렬화 */
 };
 
 #include "threads/thread.h"
@@ -116,6 +121,7 @@ bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
 void vm_init (void);
+void vm_print_stats (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -132,5 +138,20 @@ bool page_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux
 bool insert_page(struct hash *pages, struct page *p);
 bool delete_page(struct hash *pages, struct page *p);
 void spt_destructor(struct hash_elem *e, void* aux);
+void vm_free_frame (struct page *page);
+void vm_clear_range (uint64_t *pml4, void *start, void *end);
+bool vm_reclaim_frame (void);
+void vm_set_rss_limit (size_t pages);
+size_t vm_pin_frames (bool (*filter) (struct page *, void *), void *aux,
+		struct page **pages, size_t max);
+void vm_unpin_frames (struct page **pages, size_t cnt);
+void vm_add_frame_cursor (struct frame *cursor);
+size_t vm_pin_frames_after (struct frame *cursor,
+		bool (*filter) (struct page *, void *), void *aux,
+		struct page **pages, size_t max);
+bool vm_try_pin_frame (struct page *page);
+void vm_unpin_frame (struct frame *frame);
+void *vm_detach_frame (struct frame *frame);
+bool vm_prefetch_page (struct supplemental_page_table *spt, void *va);
 
 #endif  /* VM_VM_H */
\ No newline at end of file
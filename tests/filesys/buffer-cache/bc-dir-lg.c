@@ -0,0 +1,55 @@
+/* Creates 10,000 files in one directory, then opens and removes them
+   in a scattered order.  This finishes within the time limit only if
+   looking up and adding a name does not read the whole directory. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 10000
+
+static void
+file_name (char *name, size_t size, int i) {
+  snprintf (name, size, "big/f%d", i);
+}
+
+void
+test_main (void) {
+  char name[32];
+  int i, fd;
+
+  CHECK (mkdir ("big"), "mkdir \"big\"");
+
+  msg ("create %d files", FILE_CNT);
+  for (i = 0; i < FILE_CNT; i++) {
+    file_name (name, sizeof name, i);
+    if (!create (name, 0))
+      fail ("create \"%s\" failed", name);
+  }
+
+  msg ("open every file");
+  for (i = 0; i < FILE_CNT; i++) {
+    file_name (name, sizeof name, i * 7919 % FILE_CNT);
+    if ((fd = open (name)) < 2)
+      fail ("open \"%s\" failed", name);
+    close (fd);
+  }
+
+  msg ("remove every other file");
+  for (i = 0; i < FILE_CNT; i += 2) {
+    file_name (name, sizeof name, i);
+    if (!remove (name))
+      fail ("remove \"%s\" failed", name);
+  }
+
+  msg ("look the files up again");
+  for (i = 0; i < FILE_CNT; i++) {
+    file_name (name, sizeof name, i);
+    fd = open (name);
+    if ((i % 2 == 0) != (fd < 2))
+      fail ("open \"%s\" returned %d", name, fd);
+    if (fd >= 2)
+      close (fd);
+  }
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-dir-lg) begin
+(bc-dir-lg) mkdir "big"
+(bc-dir-lg) create 10000 files
+(bc-dir-lg) open every file
+(bc-dir-lg) remove every other file
+(bc-dir-lg) look the files up again
+(bc-dir-lg) end
+EOF
+pass;
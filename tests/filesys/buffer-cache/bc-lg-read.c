@@ -0,0 +1,61 @@
+/* Writes a large file, then reads it back sequentially and in random
+   order, block by block.  Every block read has to be mapped to its
+   disk sector, so this runs within the time limit only if that lookup
+   does not walk the file's whole FAT chain each time. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_SIZE 512
+#define TEST_SIZE (512 * 1280)
+#define BLOCK_CNT (TEST_SIZE / BLOCK_SIZE)
+#define ROUNDS 4
+
+static const char file_name[] = "large";
+static char buf[TEST_SIZE];
+static int order[BLOCK_CNT];
+
+static void
+read_block (int fd, size_t ofs) {
+  char block[BLOCK_SIZE];
+
+  seek (fd, ofs);
+  if (read (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+    fail ("read %d bytes at offset %zu failed", (int) BLOCK_SIZE, ofs);
+  compare_bytes (block, buf + ofs, BLOCK_SIZE, ofs, file_name);
+}
+
+void
+test_main (void) {
+  int fd;
+  size_t i;
+  int round;
+
+  random_init (42);
+  random_bytes (buf, sizeof buf);
+  for (i = 0; i < BLOCK_CNT; i++)
+    order[i] = i;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (write (fd, buf, sizeof buf) == sizeof buf,
+         "write %d bytes to \"%s\"", TEST_SIZE, file_name);
+
+  msg ("read \"%s\" sequentially", file_name);
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0; i < BLOCK_CNT; i++)
+      read_block (fd, BLOCK_SIZE * i);
+
+  msg ("read \"%s\" in random order", file_name);
+  for (round = 0; round < ROUNDS; round++) {
+    shuffle (order, BLOCK_CNT, sizeof *order);
+    for (i = 0; i < BLOCK_CNT; i++)
+      read_block (fd, BLOCK_SIZE * order[i]);
+  }
+
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
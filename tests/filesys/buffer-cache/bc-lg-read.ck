@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-lg-read) begin
+(bc-lg-read) create "large"
+(bc-lg-read) open "large"
+(bc-lg-read) write 655360 bytes to "large"
+(bc-lg-read) read "large" sequentially
+(bc-lg-read) read "large" in random order
+(bc-lg-read) close "large"
+(bc-lg-read) end
+EOF
+pass;
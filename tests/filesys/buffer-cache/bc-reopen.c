@@ -0,0 +1,54 @@
+/* Opens, reads and closes the same few files over and over.  Once the
+   files have been read the first time, their inodes and data stay in
+   memory after they are closed, so the loop should not read the disk. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 4
+#define FILE_SIZE 2048
+#define ROUNDS 100
+
+static char buf[FILE_CNT][FILE_SIZE];
+
+/* Opens file I, checks its contents and closes it. */
+static void
+read_file (int i) {
+  static char block[FILE_SIZE];
+  char name[16];
+  int fd;
+
+  snprintf (name, sizeof name, "file%d", i);
+  if ((fd = open (name)) < 2)
+    fail ("open \"%s\" failed", name);
+  if (read (fd, block, FILE_SIZE) != FILE_SIZE)
+    fail ("read \"%s\" failed", name);
+  compare_bytes (block, buf[i], FILE_SIZE, 0, name);
+  close (fd);
+}
+
+void
+test_main (void) {
+  char name[16];
+  long long read_cnt;
+  int i, fd, round;
+
+  random_bytes (buf, sizeof buf);
+  for (i = 0; i < FILE_CNT; i++) {
+    snprintf (name, sizeof name, "file%d", i);
+    CHECK (create (name, 0), "create \"%s\"", name);
+    CHECK ((fd = open (name)) > 1, "open \"%s\"", name);
+    CHECK (write (fd, buf[i], FILE_SIZE) == FILE_SIZE, "write \"%s\"", name);
+    close (fd);
+    read_file (i);
+  }
+
+  read_cnt = get_fs_disk_read_cnt ();
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0; i < FILE_CNT; i++)
+      read_file (i);
+  CHECK (get_fs_disk_read_cnt () <= read_cnt + 4, "check read_cnt");
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-reopen) begin
+(bc-reopen) create "file0"
+(bc-reopen) open "file0"
+(bc-reopen) write "file0"
+(bc-reopen) create "file1"
+(bc-reopen) open "file1"
+(bc-reopen) write "file1"
+(bc-reopen) create "file2"
+(bc-reopen) open "file2"
+(bc-reopen) write "file2"
+(bc-reopen) create "file3"
+(bc-reopen) open "file3"
+(bc-reopen) write "file3"
+(bc-reopen) check read_cnt
+(bc-reopen) end
+EOF
+pass;
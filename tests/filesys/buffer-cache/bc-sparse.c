@@ -0,0 +1,54 @@
+/* Creates a large file and grows another one by writing far past its
+   end, then reads both back.  Neither the file created nor the gap left
+   behind has been written, so creating, growing and reading them back
+   should hardly touch the disk. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LARGE_SIZE (512 * 1024)
+#define SPARSE_OFS (512 * 768)
+#define BLOCK_SIZE 4096
+
+static char zeros[BLOCK_SIZE];
+
+/* Checks that SIZE bytes of FD from offset 0 read back as zeros. */
+static void
+check_zeros (int fd, const char *file_name, int size) {
+  static char block[BLOCK_SIZE];
+  int ofs;
+
+  seek (fd, 0);
+  for (ofs = 0; ofs < size; ofs += BLOCK_SIZE) {
+    if (read (fd, block, BLOCK_SIZE) != BLOCK_SIZE)
+      fail ("read %d bytes at offset %d failed", BLOCK_SIZE, ofs);
+    compare_bytes (block, zeros, BLOCK_SIZE, ofs, file_name);
+  }
+}
+
+void
+test_main (void) {
+  int fd;
+  char c = 'x';
+  long long read_cnt, write_cnt;
+
+  write_cnt = get_fs_disk_write_cnt ();
+  CHECK (create ("large", LARGE_SIZE), "create \"large\"");
+  CHECK (create ("sparse", 0), "create \"sparse\"");
+  CHECK ((fd = open ("sparse")) > 1, "open \"sparse\"");
+  seek (fd, SPARSE_OFS);
+  CHECK (write (fd, &c, 1) == 1, "write 1 byte at offset %d", SPARSE_OFS);
+  CHECK (get_fs_disk_write_cnt () <= write_cnt + 16, "check write_cnt");
+
+  read_cnt = get_fs_disk_read_cnt ();
+  check_zeros (fd, "sparse", SPARSE_OFS);
+  if (read (fd, &c, 1) != 1 || c != 'x')
+    fail ("byte at offset %d is not 'x'", SPARSE_OFS);
+  close (fd);
+  CHECK ((fd = open ("large")) > 1, "open \"large\"");
+  check_zeros (fd, "large", LARGE_SIZE);
+  close (fd);
+  CHECK (get_fs_disk_read_cnt () <= read_cnt + 16, "check read_cnt");
+}
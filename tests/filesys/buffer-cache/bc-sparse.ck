@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(bc-sparse) begin
+(bc-sparse) create "large"
+(bc-sparse) create "sparse"
+(bc-sparse) open "sparse"
+(bc-sparse) write 1 byte at offset 393216
+(bc-sparse) check write_cnt
+(bc-sparse) open "large"
+(bc-sparse) check read_cnt
+(bc-sparse) end
+EOF
+pass;
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_archive ({
+    "a" => {
+	"f0" => ['a' x 500],
+	"f2" => ['c' x 1500],
+	"f3" => ['d' x 2000],
+	"f5" => ['f' x 3000],
+	"l" => ['a' x 500],
+	"b" => {"g" => ['g' x 3000]}
+    }
+});
+pass;
@@ -0,0 +1,46 @@
+/* Makes directories, creates, writes, removes and links files in them,
+   and powers off with -journal-crash, which leaves the last journal
+   transaction logged but not written in place.  The persistence check
+   passes only if the next mount replays it. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[3000];
+
+static void
+write_file (const char *file_name, char c, size_t size)
+{
+  int fd;
+
+  memset (buf, c, size);
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (write (fd, buf, size) == (int) size, "write \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
+
+void
+test_main (void)
+{
+  char name[16];
+  int i;
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK (mkdir ("a/b"), "mkdir \"a/b\"");
+  for (i = 0; i < 6; i++)
+    {
+      snprintf (name, sizeof name, "a/f%d", i);
+      write_file (name, 'a' + i, 500 * (i + 1));
+    }
+  CHECK (remove ("a/f1"), "remove \"a/f1\"");
+  CHECK (remove ("a/f4"), "remove \"a/f4\"");
+  write_file ("a/b/g", 'g', 3000);
+  CHECK (symlink ("a/f0", "a/l") == 0, "symlink \"a/l\"");
+  CHECK (mkdir ("a/c"), "mkdir \"a/c\"");
+  CHECK (remove ("a/c"), "remove \"a/c\"");
+}
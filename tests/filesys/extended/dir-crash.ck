@@ -0,0 +1,44 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-crash) begin
+(dir-crash) mkdir "a"
+(dir-crash) mkdir "a/b"
+(dir-crash) create "a/f0"
+(dir-crash) open "a/f0"
+(dir-crash) write "a/f0"
+(dir-crash) close "a/f0"
+(dir-crash) create "a/f1"
+(dir-crash) open "a/f1"
+(dir-crash) write "a/f1"
+(dir-crash) close "a/f1"
+(dir-crash) create "a/f2"
+(dir-crash) open "a/f2"
+(dir-crash) write "a/f2"
+(dir-crash) close "a/f2"
+(dir-crash) create "a/f3"
+(dir-crash) open "a/f3"
+(dir-crash) write "a/f3"
+(dir-crash) close "a/f3"
+(dir-crash) create "a/f4"
+(dir-crash) open "a/f4"
+(dir-crash) write "a/f4"
+(dir-crash) close "a/f4"
+(dir-crash) create "a/f5"
+(dir-crash) open "a/f5"
+(dir-crash) write "a/f5"
+(dir-crash) close "a/f5"
+(dir-crash) remove "a/f1"
+(dir-crash) remove "a/f4"
+(dir-crash) create "a/b/g"
+(dir-crash) open "a/b/g"
+(dir-crash) write "a/b/g"
+(dir-crash) close "a/b/g"
+(dir-crash) symlink "a/l"
+(dir-crash) mkdir "a/c"
+(dir-crash) remove "a/c"
+(dir-crash) end
+EOF
+pass;
@@ -0,0 +1,47 @@
+/* Looks names up, removes them and creates them again, checking that
+   no lookup sees an entry that was removed: a removed file cannot be
+   opened, a file created in its place has the new contents, and a
+   directory created in place of a removed one is empty. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char old_buf[1000];
+static char new_buf[700];
+
+static void
+write_file (const char *file_name, const char *buf, size_t size)
+{
+  int fd;
+
+  CHECK (create (file_name, 0), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  CHECK (write (fd, buf, size) == (int) size, "write \"%s\"", file_name);
+  msg ("close \"%s\"", file_name);
+  close (fd);
+}
+
+void
+test_main (void)
+{
+  memset (old_buf, 'o', sizeof old_buf);
+  memset (new_buf, 'n', sizeof new_buf);
+
+  write_file ("f", old_buf, sizeof old_buf);
+  check_file ("f", old_buf, sizeof old_buf);
+  CHECK (remove ("f"), "remove \"f\"");
+  CHECK (open ("f") == -1, "open \"f\" (must return -1)");
+  write_file ("f", new_buf, sizeof new_buf);
+  check_file ("f", new_buf, sizeof new_buf);
+
+  CHECK (mkdir ("d"), "mkdir \"d\"");
+  write_file ("d/g", old_buf, sizeof old_buf);
+  check_file ("d/g", old_buf, sizeof old_buf);
+  CHECK (remove ("d/g"), "remove \"d/g\"");
+  CHECK (remove ("d"), "remove \"d\"");
+  CHECK (open ("d/g") == -1, "open \"d/g\" (must return -1)");
+  CHECK (mkdir ("d"), "mkdir \"d\"");
+  CHECK (open ("d/g") == -1, "open \"d/g\" (must return -1)");
+}
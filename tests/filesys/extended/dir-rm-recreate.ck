@@ -0,0 +1,38 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-rm-recreate) begin
+(dir-rm-recreate) create "f"
+(dir-rm-recreate) open "f"
+(dir-rm-recreate) write "f"
+(dir-rm-recreate) close "f"
+(dir-rm-recreate) open "f" for verification
+(dir-rm-recreate) verified contents of "f"
+(dir-rm-recreate) close "f"
+(dir-rm-recreate) remove "f"
+(dir-rm-recreate) open "f" (must return -1)
+(dir-rm-recreate) create "f"
+(dir-rm-recreate) open "f"
+(dir-rm-recreate) write "f"
+(dir-rm-recreate) close "f"
+(dir-rm-recreate) open "f" for verification
+(dir-rm-recreate) verified contents of "f"
+(dir-rm-recreate) close "f"
+(dir-rm-recreate) mkdir "d"
+(dir-rm-recreate) create "d/g"
+(dir-rm-recreate) open "d/g"
+(dir-rm-recreate) write "d/g"
+(dir-rm-recreate) close "d/g"
+(dir-rm-recreate) open "d/g" for verification
+(dir-rm-recreate) verified contents of "d/g"
+(dir-rm-recreate) close "d/g"
+(dir-rm-recreate) remove "d/g"
+(dir-rm-recreate) remove "d"
+(dir-rm-recreate) open "d/g" (must return -1)
+(dir-rm-recreate) mkdir "d"
+(dir-rm-recreate) open "d/g" (must return -1)
+(dir-rm-recreate) end
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Grows a file through one descriptor while another stays open, so
+   that its new length is written back only by the process exit that
+   closes the last descriptor.  The length must be seen by every opener
+   meanwhile, and must be on disk after the file system is mounted
+   again. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_SIZE 1234
+#define FILE_SIZE (BLOCK_SIZE * 50)
+static char buf[FILE_SIZE];
+
+void
+test_main (void)
+{
+  int fd_write, fd_keep;
+  size_t ofs;
+
+  random_init (0);
+  random_bytes (buf, sizeof buf);
+
+  CHECK (create ("late", 0), "create \"late\"");
+  CHECK ((fd_keep = open ("late")) > 1, "open \"late\"");
+  CHECK ((fd_write = open ("late")) > 1, "open \"late\" again");
+
+  msg ("write \"late\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE)
+    {
+      if (write (fd_write, buf + ofs, BLOCK_SIZE) != BLOCK_SIZE)
+        fail ("write %d bytes at offset %zu in \"late\" failed",
+              BLOCK_SIZE, ofs);
+      if (filesize (fd_keep) != (int) (ofs + BLOCK_SIZE))
+        fail ("filesize of \"late\" is %d after %zu bytes written",
+              filesize (fd_keep), ofs + BLOCK_SIZE);
+    }
+  msg ("close \"late\"");
+  close (fd_write);
+
+  check_file ("late", buf, sizeof buf);
+
+  /* fd_keep is left open for exit to close. */
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-close-late) begin
+(grow-close-late) create "late"
+(grow-close-late) open "late"
+(grow-close-late) open "late" again
+(grow-close-late) write "late"
+(grow-close-late) close "late"
+(grow-close-late) open "late" for verification
+(grow-close-late) verified contents of "late"
+(grow-close-late) close "late"
+(grow-close-late) end
+EOF
+pass;
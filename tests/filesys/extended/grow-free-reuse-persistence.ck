@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::random;
+my ($keep) = random_bytes (131072);
+my ($new) = random_bytes (196608);
+check_archive ({"keep" => [$keep], "new" => [$new]});
+pass;
@@ -0,0 +1,66 @@
+/* Grows two files in turn across many FAT sectors, removes the larger
+   one and grows a third file into the clusters it freed.  The
+   persistence check then needs the FAT and the free cluster bitmap as
+   they were changed last, after the file system is mounted again. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_SIZE 4096
+#define KEEP_SIZE (BLOCK_SIZE * 32)
+#define BIG_SIZE (BLOCK_SIZE * 64)
+#define NEW_SIZE (BLOCK_SIZE * 48)
+static char buf_keep[KEEP_SIZE];
+static char buf_new[NEW_SIZE];
+
+static void
+write_block (const char *file_name, int fd, const char *buf)
+{
+  int ret_val = write (fd, buf, BLOCK_SIZE);
+  if (ret_val != BLOCK_SIZE)
+    fail ("write %d bytes to \"%s\" returned %d",
+          BLOCK_SIZE, file_name, ret_val);
+}
+
+void
+test_main (void)
+{
+  int fd_keep, fd_big, fd_new;
+  size_t ofs;
+
+  random_init (0);
+  random_bytes (buf_keep, sizeof buf_keep);
+  random_bytes (buf_new, sizeof buf_new);
+
+  CHECK (create ("keep", 0), "create \"keep\"");
+  CHECK (create ("big", 0), "create \"big\"");
+  CHECK ((fd_keep = open ("keep")) > 1, "open \"keep\"");
+  CHECK ((fd_big = open ("big")) > 1, "open \"big\"");
+
+  msg ("write \"keep\" and \"big\" in turn");
+  for (ofs = 0; ofs < BIG_SIZE; ofs += BLOCK_SIZE)
+    {
+      if (ofs < KEEP_SIZE)
+        write_block ("keep", fd_keep, buf_keep + ofs);
+      write_block ("big", fd_big, buf_new + ofs % NEW_SIZE);
+    }
+
+  msg ("close \"keep\"");
+  close (fd_keep);
+  msg ("close \"big\"");
+  close (fd_big);
+  CHECK (remove ("big"), "remove \"big\"");
+
+  CHECK (create ("new", 0), "create \"new\"");
+  CHECK ((fd_new = open ("new")) > 1, "open \"new\"");
+  msg ("write \"new\"");
+  for (ofs = 0; ofs < NEW_SIZE; ofs += BLOCK_SIZE)
+    write_block ("new", fd_new, buf_new + ofs);
+  msg ("close \"new\"");
+  close (fd_new);
+
+  check_file ("keep", buf_keep, sizeof buf_keep);
+  check_file ("new", buf_new, sizeof buf_new);
+}
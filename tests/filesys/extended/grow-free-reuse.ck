@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-free-reuse) begin
+(grow-free-reuse) create "keep"
+(grow-free-reuse) create "big"
+(grow-free-reuse) open "keep"
+(grow-free-reuse) open "big"
+(grow-free-reuse) write "keep" and "big" in turn
+(grow-free-reuse) close "keep"
+(grow-free-reuse) close "big"
+(grow-free-reuse) remove "big"
+(grow-free-reuse) create "new"
+(grow-free-reuse) open "new"
+(grow-free-reuse) write "new"
+(grow-free-reuse) close "new"
+(grow-free-reuse) open "keep" for verification
+(grow-free-reuse) verified contents of "keep"
+(grow-free-reuse) close "keep"
+(grow-free-reuse) open "new" for verification
+(grow-free-reuse) verified contents of "new"
+(grow-free-reuse) close "new"
+(grow-free-reuse) end
+EOF
+pass;
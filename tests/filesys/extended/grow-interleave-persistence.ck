@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::random;
+my ($a) = random_bytes (40960);
+my ($b) = random_bytes (20480);
+my ($c) = random_bytes (20480);
+my ($d) = random_bytes (20480);
+check_archive ({"a" => [$a], "c" => [$c], "d" => [$d]});
+pass;
@@ -0,0 +1,80 @@
+/* Grows three files a sector at a time in turn, removes the middle
+   one and grows a new file and the first one again in turn, so that
+   clusters are allocated both after each file's last cluster and in
+   the hole the removed file left.  Checks that every file's contents
+   are correct. */
+
+#include <random.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_SIZE 512
+#define FILE_SIZE (BLOCK_SIZE * 40)
+static char buf_a[FILE_SIZE * 2];
+static char buf_b[FILE_SIZE];
+static char buf_c[FILE_SIZE];
+static char buf_d[FILE_SIZE];
+
+static void
+write_block (const char *file_name, int fd, const char *buf, size_t ofs)
+{
+  int ret_val = write (fd, buf + ofs, BLOCK_SIZE);
+  if (ret_val != BLOCK_SIZE)
+    fail ("write %d bytes at offset %zu in \"%s\" returned %d",
+          BLOCK_SIZE, ofs, file_name, ret_val);
+}
+
+void
+test_main (void)
+{
+  int fd_a, fd_b, fd_c, fd_d;
+  size_t ofs;
+
+  random_init (0);
+  random_bytes (buf_a, sizeof buf_a);
+  random_bytes (buf_b, sizeof buf_b);
+  random_bytes (buf_c, sizeof buf_c);
+  random_bytes (buf_d, sizeof buf_d);
+
+  CHECK (create ("a", 0), "create \"a\"");
+  CHECK (create ("b", 0), "create \"b\"");
+  CHECK (create ("c", 0), "create \"c\"");
+  CHECK ((fd_a = open ("a")) > 1, "open \"a\"");
+  CHECK ((fd_b = open ("b")) > 1, "open \"b\"");
+  CHECK ((fd_c = open ("c")) > 1, "open \"c\"");
+
+  msg ("write \"a\", \"b\" and \"c\" in turn");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE)
+    {
+      write_block ("a", fd_a, buf_a, ofs);
+      write_block ("b", fd_b, buf_b, ofs);
+      write_block ("c", fd_c, buf_c, ofs);
+    }
+
+  msg ("close \"b\"");
+  close (fd_b);
+  msg ("close \"c\"");
+  close (fd_c);
+  CHECK (remove ("b"), "remove \"b\"");
+
+  CHECK (create ("d", 0), "create \"d\"");
+  CHECK ((fd_d = open ("d")) > 1, "open \"d\"");
+
+  msg ("write \"a\" and \"d\" in turn");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += BLOCK_SIZE)
+    {
+      write_block ("a", fd_a, buf_a, FILE_SIZE + ofs);
+      write_block ("d", fd_d, buf_d, ofs);
+    }
+
+  msg ("close \"a\"");
+  close (fd_a);
+  msg ("close \"d\"");
+  close (fd_d);
+
+  CHECK (open ("b") == -1, "open \"b\" (must return -1)");
+  check_file ("a", buf_a, sizeof buf_a);
+  check_file ("c", buf_c, sizeof buf_c);
+  check_file ("d", buf_d, sizeof buf_d);
+}
@@ -0,0 +1,34 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(grow-interleave) begin
+(grow-interleave) create "a"
+(grow-interleave) create "b"
+(grow-interleave) create "c"
+(grow-interleave) open "a"
+(grow-interleave) open "b"
+(grow-interleave) open "c"
+(grow-interleave) write "a", "b" and "c" in turn
+(grow-interleave) close "b"
+(grow-interleave) close "c"
+(grow-interleave) remove "b"
+(grow-interleave) create "d"
+(grow-interleave) open "d"
+(grow-interleave) write "a" and "d" in turn
+(grow-interleave) close "a"
+(grow-interleave) close "d"
+(grow-interleave) open "b" (must return -1)
+(grow-interleave) open "a" for verification
+(grow-interleave) verified contents of "a"
+(grow-interleave) close "a"
+(grow-interleave) open "c" for verification
+(grow-interleave) verified contents of "c"
+(grow-interleave) close "c"
+(grow-interleave) open "d" for verification
+(grow-interleave) verified contents of "d"
+(grow-interleave) close "d"
+(grow-interleave) end
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Writes a 64 kB buffer to a file with one write system call and
+   reads it back with one read system call.  The kernel prints the
+   time spent in read and write at power-off, so this doubles as a
+   benchmark for large user copies. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+
+static char wbuf[SIZE];
+static char rbuf[SIZE];
+
+void
+test_main (void) 
+{
+  int handle, byte_cnt;
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    wbuf[i] = i * 7 + 3;
+
+  CHECK (create ("large.txt", SIZE), "create \"large.txt\"");
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  byte_cnt = write (handle, wbuf, SIZE);
+  if (byte_cnt != SIZE)
+    fail ("write() returned %d instead of %d", byte_cnt, SIZE);
+  close (handle);
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  byte_cnt = read (handle, rbuf, SIZE);
+  if (byte_cnt != SIZE)
+    fail ("read() returned %d instead of %d", byte_cnt, SIZE);
+  CHECK (!memcmp (rbuf, wbuf, SIZE), "compare read data against written data");
+  close (handle);
+}
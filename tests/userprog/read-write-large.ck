@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(read-write-large) begin
+(read-write-large) create "large.txt"
+(read-write-large) open "large.txt"
+(read-write-large) open "large.txt"
+(read-write-large) compare read data against written data
+(read-write-large) end
+read-write-large: exit(0)
+EOF
+pass;
@@ -0,0 +1,29 @@
+/* Writes and checks CHUNK_SIZE bytes of anonymous memory, more than the
+ * user pool holds, while staying within the RSS limit that swap-rss set
+ * before exec. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/rss.h"
+
+#define CHUNK_SIZE (6 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      big_chunks[i * PAGE_SIZE] = (char) i;
+      if (getrss () > CHILD_RSS_LIMIT)
+        fail ("%zu pages resident, limit is %d", getrss (), CHILD_RSS_LIMIT);
+    }
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunks[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+}
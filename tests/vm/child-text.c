@@ -0,0 +1,32 @@
+/* Child process of page-share-text.
+   Checks that its read-only data, initialized data and zeroed data hold
+   what the executable says they do, while other processes run the same
+   executable and share its read-only pages. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+const char *test_name = "child-text";
+
+#define CNT 3000
+
+static const int table[CNT] = { [0 ... CNT - 1] = 0x3c3c3c3c };
+static int data[CNT] = { [0 ... CNT - 1] = 0x5a5a5a5a };
+static int bss[CNT];
+
+int
+main (int argc UNUSED, char *argv[] UNUSED)
+{
+  int i;
+
+  for (i = 0; i < CNT; i++)
+    {
+      if (table[i] != 0x3c3c3c3c)
+        fail ("table[%d] is %x", i, table[i]);
+      if (data[i] != 0x5a5a5a5a)
+        fail ("data[%d] is %x", i, data[i]);
+      if (bss[i] != 0)
+        fail ("bss[%d] is %x", i, bss[i]);
+    }
+  return 0x42;
+}
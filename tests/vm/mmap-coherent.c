@@ -0,0 +1,40 @@
+/* Maps a file and checks that read() and write() on the same file see
+   stores through the mapping, and the mapping sees write()s, without
+   msync or munmap in between. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  char buf[64];
+  int handle;
+  char *map;
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (write (handle, sample, strlen (sample)) == (int) strlen (sample),
+         "write \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  CHECK (!memcmp (map, sample, strlen (sample)),
+         "compare mapping against written data");
+
+  memcpy (map, "COHERENT", 8);
+  seek (handle, 0);
+  CHECK (read (handle, buf, 8) == 8 && !memcmp (buf, "COHERENT", 8),
+         "read sees store through mapping");
+
+  seek (handle, 100);
+  CHECK (write (handle, "WRITTEN", 7) == 7, "write at offset 100");
+  CHECK (!memcmp (map + 100, "WRITTEN", 7), "mapping sees write");
+
+  munmap (map);
+  close (handle);
+}
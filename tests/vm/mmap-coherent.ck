@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-coherent) begin
+(mmap-coherent) create "sample.txt"
+(mmap-coherent) open "sample.txt"
+(mmap-coherent) write "sample.txt"
+(mmap-coherent) mmap "sample.txt"
+(mmap-coherent) compare mapping against written data
+(mmap-coherent) read sees store through mapping
+(mmap-coherent) write at offset 100
+(mmap-coherent) mapping sees write
+(mmap-coherent) end
+EOF
+pass;
@@ -0,0 +1,47 @@
+/* Maps a file with MAP_POPULATE and reads it sequentially, drops the
+   mapping's frames with MADV_DONTNEED and checks that the data comes
+   back from the file, then checks that MADV_DONTNEED on anonymous
+   memory makes it read as zeros. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+static char anon[4096] __attribute__ ((aligned (4096)));
+
+void
+test_main (void)
+{
+  int handle;
+  char *map;
+  size_t i;
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1 | MAP_POPULATE, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\" with MAP_POPULATE");
+  CHECK (madvise (map, 4096, MADV_SEQUENTIAL), "madvise sequential");
+  CHECK (!memcmp (map, sample, strlen (sample)),
+         "compare populated mapping against file");
+
+  memcpy (map, "MADVISE", 7);
+  CHECK (madvise (map, 4096, MADV_DONTNEED), "madvise dontneed on mapping");
+  CHECK (!memcmp (map, "MADVISE", 7) && !memcmp (map + 7, sample + 7, 100),
+         "mapping keeps written data");
+  CHECK (!madvise (ACTUAL + 4096, 4096, MADV_WILLNEED),
+         "madvise of unmapped range must fail");
+  CHECK (!madvise (map, 4096, 99), "madvise with unknown advice must fail");
+  munmap (map);
+  close (handle);
+
+  memset (anon, 0xcc, sizeof anon);
+  CHECK (madvise (anon, sizeof anon, MADV_DONTNEED), "madvise dontneed on anon");
+  for (i = 0; i < sizeof anon; i++)
+    if (anon[i] != 0)
+      fail ("byte %zu is %d after MADV_DONTNEED", i, anon[i]);
+  msg ("anon memory reads as zeros");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-madvise) begin
+(mmap-madvise) create "sample.txt"
+(mmap-madvise) open "sample.txt"
+(mmap-madvise) mmap "sample.txt" with MAP_POPULATE
+(mmap-madvise) madvise sequential
+(mmap-madvise) compare populated mapping against file
+(mmap-madvise) madvise dontneed on mapping
+(mmap-madvise) mapping keeps written data
+(mmap-madvise) madvise of unmapped range must fail
+(mmap-madvise) madvise with unknown advice must fail
+(mmap-madvise) anon memory reads as zeros
+(mmap-madvise) end
+EOF
+pass;
@@ -0,0 +1,60 @@
+/* Maps a file over a range that crosses a page table boundary, reads
+   every page, unmaps it and maps a different file at the same address.
+   Every page must show the new file, so none of the old mappings may
+   survive the unmap, and the range must be inaccessible once the
+   second file is unmapped as well. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE 4096
+#define PAGES 64
+/* 32 pages on either side of a 2 MB boundary. */
+#define ACTUAL ((char *) 0x101e0000)
+
+static char page[PAGE];
+
+/* Creates NAME, PAGES pages of C. */
+static void
+make_file (const char *name, char c)
+{
+  int handle, i;
+
+  CHECK (create (name, 0), "create \"%s\"", name);
+  CHECK ((handle = open (name)) > 1, "open \"%s\"", name);
+  memset (page, c, PAGE);
+  for (i = 0; i < PAGES; i++)
+    if (write (handle, page, PAGE) != PAGE)
+      fail ("write \"%s\"", name);
+  close (handle);
+}
+
+/* Maps NAME at ACTUAL, checks that every page holds C and unmaps it. */
+static void
+map_and_check (const char *name, char c)
+{
+  int handle, i;
+  void *map;
+
+  CHECK ((handle = open (name)) > 1, "open \"%s\"", name);
+  CHECK ((map = mmap (ACTUAL, PAGES * PAGE, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"%s\"", name);
+  for (i = 0; i < PAGES; i++)
+    if (ACTUAL[i * PAGE] != c || ACTUAL[i * PAGE + PAGE - 1] != c)
+      fail ("page %d of \"%s\" holds %c", i, name, ACTUAL[i * PAGE]);
+  munmap (map);
+  close (handle);
+}
+
+void
+test_main (void)
+{
+  make_file ("a", 'a');
+  make_file ("b", 'b');
+  map_and_check ("a", 'a');
+  map_and_check ("b", 'b');
+
+  fail ("unmapped memory is readable (%c)", ACTUAL[PAGES / 2 * PAGE]);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mmap-remap) begin
+(mmap-remap) create "a"
+(mmap-remap) open "a"
+(mmap-remap) create "b"
+(mmap-remap) open "b"
+(mmap-remap) open "a"
+(mmap-remap) mmap "a"
+(mmap-remap) open "b"
+(mmap-remap) mmap "b"
+mmap-remap: exit(-1)
+EOF
+pass;
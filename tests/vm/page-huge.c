@@ -0,0 +1,48 @@
+/* Touches 4 MB of 2 MB-aligned zeroed memory, then walks it one
+   byte per page many times over, which needs one TLB entry per
+   4 kB page unless the kernel maps it with 2 MB pages.  Finally
+   drops a single page in the middle with MADV_DONTNEED and checks
+   that only that page reads back as zeros. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE 4096
+#define HUGE (2 * 1024 * 1024)
+#define SIZE (2 * HUGE)
+#define PAGES (SIZE / PAGE)
+#define ROUNDS 64
+
+static char buf[SIZE] __attribute__ ((aligned (HUGE)));
+
+void
+test_main (void)
+{
+  size_t i, round;
+  unsigned long sum = 0, expected = 0;
+  char *hole = buf + HUGE + 5 * PAGE;
+
+  msg ("write pass");
+  for (i = 0; i < PAGES; i++)
+    memset (buf + i * PAGE, i & 0x7f, PAGE);
+
+  msg ("strided read pass");
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0; i < PAGES; i++)
+      sum += buf[i * PAGE + (round * 64) % PAGE];
+  for (i = 0; i < PAGES; i++)
+    expected += (i & 0x7f) * ROUNDS;
+  if (sum != expected)
+    fail ("sum is %lu, expected %lu", sum, expected);
+
+  CHECK (madvise (hole, PAGE, MADV_DONTNEED), "madvise dontneed one page");
+  for (i = 0; i < PAGE; i++)
+    if (hole[i] != 0)
+      fail ("byte %zu of dropped page is %d", i, hole[i]);
+  for (i = 0; i < PAGES; i++)
+    if (buf + i * PAGE != hole && buf[i * PAGE + PAGE - 1] != (char) (i & 0x7f))
+      fail ("page %zu lost its contents", i);
+  msg ("only the dropped page reads as zeros");
+}
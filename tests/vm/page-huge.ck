@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-huge) begin
+(page-huge) write pass
+(page-huge) strided read pass
+(page-huge) madvise dontneed one page
+(page-huge) only the dropped page reads as zeros
+(page-huge) end
+EOF
+pass;
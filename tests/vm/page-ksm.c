@@ -0,0 +1,57 @@
+/* Fills several pages with the same bytes and waits until the ksm
+   thread has merged them into one frame, then writes to one of them
+   and checks that only that page changed and that it got a frame of
+   its own again. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE 4096
+#define PAGES 16
+#define WRITTEN 3
+#define TRIES 2000000
+
+static char buf[PAGES * PAGE];
+
+/* Returns true if every page maps the same frame. */
+static bool
+merged (void)
+{
+  void *pa = get_phys_addr (buf);
+  size_t i;
+
+  if (pa == NULL)
+    return false;
+  for (i = 1; i < PAGES; i++)
+    if (get_phys_addr (buf + i * PAGE) != pa)
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  size_t i, j;
+  int tries;
+
+  memset (buf, 0x5a, sizeof buf);
+  for (tries = 0; tries < TRIES && !merged (); tries++)
+    continue;
+  if (tries == TRIES)
+    fail ("pages were not merged");
+  msg ("identical pages merged");
+
+  buf[WRITTEN * PAGE] = 1;
+  CHECK (get_phys_addr (buf + WRITTEN * PAGE) != get_phys_addr (buf),
+         "written page has its own frame");
+  for (i = 0; i < PAGES; i++)
+    for (j = 0; j < PAGE; j++)
+      {
+        char expected = i == WRITTEN && j == 0 ? 1 : 0x5a;
+        if (buf[i * PAGE + j] != expected)
+          fail ("byte %zu of page %zu is %d", j, i, buf[i * PAGE + j]);
+      }
+  msg ("only the written page changed");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-ksm) begin
+(page-ksm) identical pages merged
+(page-ksm) written page has its own frame
+(page-ksm) only the written page changed
+(page-ksm) end
+EOF
+pass;
@@ -0,0 +1,25 @@
+/* Runs child-text 3 times in a row.  The first launch records which
+   pages of the executable it faults in; the later ones have those
+   pages read ahead of time, and must still see exactly the contents
+   of the executable. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LAUNCH_CNT 3
+
+void
+test_main (void)
+{
+  int i;
+
+  for (i = 0; i < LAUNCH_CNT; i++) {
+    pid_t child = fork ("child-text");
+    if (child == 0) {
+      if (exec ("child-text") == -1)
+        fail ("failed to exec child-text");
+    }
+    CHECK (wait (child) == 0x42, "wait for launch %d", i);
+  }
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-launch) begin
+(page-launch) wait for launch 0
+(page-launch) wait for launch 1
+(page-launch) wait for launch 2
+(page-launch) end
+EOF
+pass;
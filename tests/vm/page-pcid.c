@@ -0,0 +1,53 @@
+/* Forks 4 children that use the same virtual addresses for different
+   data.  Each writes and checks its pages over several rounds while
+   the others run, with more pages than memory holds, so pages are
+   evicted from processes that are switched out.  A TLB entry kept for
+   the wrong process, or kept after its page was evicted, shows up as
+   another process's or an old round's data. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE 4096
+#define PAGES 512
+#define ROUNDS 8
+#define CHILD_CNT 4
+
+static char buf[PAGES * PAGE];
+
+/* Writes and checks BUF as child ID. */
+static void
+run_child (int id)
+{
+  int round;
+  size_t i;
+
+  for (round = 0; round < ROUNDS; round++)
+    {
+      char value = (char) (id * 16 + round);
+      for (i = 0; i < PAGES; i++)
+        buf[i * PAGE] = value;
+      for (i = 0; i < PAGES; i++)
+        if (buf[i * PAGE] != value)
+          fail ("child %d round %d: page %zu holds %d",
+                id, round, i, buf[i * PAGE]);
+    }
+  exit (id);
+}
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) {
+    children[i] = fork ("child");
+    if (children[i] == 0)
+      run_child (i);
+  }
+  for (i = 0; i < CHILD_CNT; i++) {
+    CHECK (wait (children[i]) == i, "wait for child %d", i);
+  }
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-pcid) begin
+(page-pcid) wait for child 0
+(page-pcid) wait for child 1
+(page-pcid) wait for child 2
+(page-pcid) wait for child 3
+(page-pcid) end
+EOF
+pass;
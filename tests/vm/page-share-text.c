@@ -0,0 +1,27 @@
+/* Runs 4 child-text processes at once.  They map the same read-only
+   pages of their executable, including any page that holds the end of
+   one segment and the start of the next. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) {
+    children[i] = fork ("child-text");
+    if (children[i] == 0) {
+      if (exec ("child-text") == -1)
+        fail ("failed to exec child-text");
+    }
+  }
+  for (i = 0; i < CHILD_CNT; i++) {
+    CHECK (wait (children[i]) == 0x42, "wait for child %d", i);
+  }
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-share-text) begin
+(page-share-text) wait for child 0
+(page-share-text) wait for child 1
+(page-share-text) wait for child 2
+(page-share-text) wait for child 3
+(page-share-text) end
+EOF
+pass;
@@ -0,0 +1,61 @@
+/* Reads untouched zeroed memory, which maps the shared zero page, then
+   writes every fourth page and checks that only those pages changed.
+   A child made by fork writes to pages of both kinds; the parent then
+   checks that neither its pages nor the zero page saw those writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE 4096
+#define PAGES 64
+
+static char buf[PAGES * PAGE];
+
+/* Returns the byte page I holds after the parent's writes. */
+static char
+expected (size_t i) {
+  return i % 4 == 0 ? (char) (i + 1) : 0;
+}
+
+/* Checks the first and last byte of every page. */
+static void
+check (const char *who) {
+  size_t i;
+
+  for (i = 0; i < PAGES; i++)
+    if (buf[i * PAGE] != expected (i) || buf[i * PAGE + PAGE - 1] != expected (i))
+      fail ("%s: page %zu holds %d", who, i, buf[i * PAGE]);
+}
+
+void
+test_main (void)
+{
+  size_t i;
+  pid_t pid;
+
+  for (i = 0; i < PAGES; i++)
+    if (buf[i * PAGE] != 0 || buf[i * PAGE + PAGE - 1] != 0)
+      fail ("untouched page %zu is not zero", i);
+  msg ("untouched pages read as zeros");
+
+  for (i = 0; i < PAGES; i += 4)
+    memset (buf + i * PAGE, (char) (i + 1), PAGE);
+  check ("parent");
+  msg ("writes changed only the pages written");
+
+  pid = fork ("child");
+  if (pid == 0) {
+    check ("child");
+    for (i = 0; i < PAGES; i += 2)
+      memset (buf + i * PAGE, 0x7f, PAGE);
+    for (i = 0; i < PAGES; i++)
+      if (buf[i * PAGE] != (i % 2 == 0 ? 0x7f : 0))
+        fail ("child: page %zu holds %d after writing", i, buf[i * PAGE]);
+    exit (81);
+  }
+  CHECK (wait (pid) == 81, "wait for child");
+  check ("parent");
+  msg ("child's writes did not reach the parent");
+}
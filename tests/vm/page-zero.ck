@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-zero) begin
+(page-zero) untouched pages read as zeros
+(page-zero) writes changed only the pages written
+(page-zero) wait for child
+(page-zero) child's writes did not reach the parent
+(page-zero) end
+EOF
+pass;
@@ -0,0 +1,10 @@
+#ifndef TESTS_VM_RSS_H
+#define TESTS_VM_RSS_H
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+
+/* RSS limit, in pages, that swap-rss sets for child-rss. */
+#define CHILD_RSS_LIMIT 256
+
+#endif /* tests/vm/rss.h */
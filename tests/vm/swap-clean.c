@@ -0,0 +1,65 @@
+/* Checks that pages swapped back in keep their swap slots correctly.
+ * For this test, Pintos memory size is 10MB.
+ * Fills a chunk twice the size of memory, reads it all back so that
+ * unmodified pages are evicted again without being written, then
+ * changes every other page, so that those rewrite the slots they kept,
+ * and checks every page twice more. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+#define ONE_MB (1 << 20) // 1MB
+#define CHUNK_SIZE (20*ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+/* Returns the byte page I is expected to hold after ROUND rounds of
+ * changes. */
+static char
+expected (size_t i, int round) {
+	return (char) (i + (i % 2 ? round : 0));
+}
+
+/* Checks the first and last byte of every page. */
+static void
+check (int round) {
+	size_t i;
+
+	for (i = 0; i < PAGE_COUNT; i++) {
+		char *mem = big_chunks + i * PAGE_SIZE;
+		if (mem[0] != expected (i, round) || mem[PAGE_SIZE - 1] != expected (i, round))
+			fail ("data is inconsistent in page %zu", i);
+	}
+}
+
+void
+test_main (void)
+{
+	size_t i;
+
+	msg ("write every page");
+	for (i = 0; i < PAGE_COUNT; i++) {
+		char *mem = big_chunks + i * PAGE_SIZE;
+		mem[0] = mem[PAGE_SIZE - 1] = expected (i, 0);
+	}
+
+	msg ("read every page back");
+	check (0);
+	check (0);
+
+	msg ("change every other page");
+	for (i = 1; i < PAGE_COUNT; i += 2) {
+		char *mem = big_chunks + i * PAGE_SIZE;
+		mem[0] = mem[PAGE_SIZE - 1] = expected (i, 1);
+	}
+
+	msg ("read every page back");
+	check (1);
+	check (1);
+}
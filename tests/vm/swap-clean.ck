@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-clean) begin
+(swap-clean) write every page
+(swap-clean) read every page back
+(swap-clean) change every other page
+(swap-clean) read every page back
+(swap-clean) end
+EOF
+pass;
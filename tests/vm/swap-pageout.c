@@ -0,0 +1,36 @@
+/* Checks anonymous memory while the pageout daemon evicts it in the
+ * background.  The test runs with watermarks that keep half of the user
+ * pool free, so the daemon evicts pages all the time, including pages
+ * the test is about to touch again.  Writes a chunk larger than memory
+ * a slice at a time and checks everything written so far after every
+ * slice. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20) // 1MB
+#define CHUNK_SIZE (8*ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+#define SLICES 8
+#define SLICE_PAGES (PAGE_COUNT / SLICES)
+
+static char big_chunks[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+	size_t slice, i;
+
+	for (slice = 0; slice < SLICES; slice++) {
+		for (i = slice * SLICE_PAGES; i < (slice + 1) * SLICE_PAGES; i++)
+			big_chunks[i * PAGE_SIZE] = (char) (i * 7);
+		for (i = 0; i < (slice + 1) * SLICE_PAGES; i++)
+			if (big_chunks[i * PAGE_SIZE] != (char) (i * 7))
+				fail ("data is inconsistent in page %zu", i);
+		msg ("slice %zu checked", slice);
+	}
+}
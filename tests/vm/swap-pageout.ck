@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-pageout) begin
+(swap-pageout) slice 0 checked
+(swap-pageout) slice 1 checked
+(swap-pageout) slice 2 checked
+(swap-pageout) slice 3 checked
+(swap-pageout) slice 4 checked
+(swap-pageout) slice 5 checked
+(swap-pageout) slice 6 checked
+(swap-pageout) slice 7 checked
+(swap-pageout) end
+EOF
+pass;
@@ -0,0 +1,49 @@
+/* Touches a small working set, then runs child-rss, which writes far
+ * more anonymous memory than fits in the user pool, under an RSS limit.
+ * Since child-rss has to evict its own pages, the small working set
+ * must still be resident afterwards.
+ * For this test, Pintos memory size is 10MB. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/rss.h"
+
+#define SMALL_PAGES 32
+
+static char small[SMALL_PAGES * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  size_t i, before;
+  pid_t child;
+
+  /* Give every page different contents, so none is merged. */
+  for (i = 0; i < SMALL_PAGES; i++)
+    {
+      memset (small + i * PAGE_SIZE, 0x5a, PAGE_SIZE);
+      small[i * PAGE_SIZE] = (char) i;
+    }
+  before = getrss ();
+  CHECK (before >= SMALL_PAGES, "touch %d pages", SMALL_PAGES);
+
+  child = fork ("child-rss");
+  if (child == 0)
+    {
+      setrss (CHILD_RSS_LIMIT);
+      if (exec ("child-rss") == -1)
+        fail ("exec \"child-rss\"");
+    }
+  CHECK (wait (child) == 0, "wait for child-rss");
+
+  if (getrss () < before)
+    fail ("working set was evicted: %zu pages resident, %zu before",
+          getrss (), before);
+  for (i = 0; i < SMALL_PAGES; i++)
+    if (small[i * PAGE_SIZE] != (char) i
+        || small[i * PAGE_SIZE + 1] != 0x5a)
+      fail ("data is inconsistent in page %zu", i);
+  msg ("working set still resident");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-rss) begin
+(swap-rss) touch 32 pages
+(child-rss) begin
+(child-rss) end
+(swap-rss) wait for child-rss
+(swap-rss) working set still resident
+(swap-rss) end
+EOF
+pass;
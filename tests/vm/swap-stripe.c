@@ -0,0 +1,42 @@
+/* Checks that anonymous pages are swapped out and in properly when swap
+ * is striped over two areas, neither of which can hold all of them.
+ * For this test, Pintos memory size is 10MB, and each swap area is 12MB.
+ * Compare the per-area counts in the kernel statistics and the run time
+ * with swap-anon for the effect of striping. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+#define ONE_MB (1 << 20) // 1MB
+#define CHUNK_SIZE (20*ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+    size_t i;
+    char *mem;
+
+    for (i = 0 ; i < PAGE_COUNT ; i++) {
+        if (!(i % 1024))
+            msg ("write page %zu", i);
+        mem = big_chunks + i * PAGE_SIZE;
+        memset (mem, (char) i, 16);
+    }
+
+    /* Twice, so that pages come back from both areas and go out again. */
+    for (i = 0 ; i < 2 * PAGE_COUNT ; i++) {
+        mem = big_chunks + (i % PAGE_COUNT) * PAGE_SIZE;
+        if (mem[0] != (char) (i % PAGE_COUNT) || mem[15] != mem[0])
+            fail ("data is inconsistent in page %zu", i % PAGE_COUNT);
+        if (!(i % 1024))
+            msg ("check page %zu", i % PAGE_COUNT);
+    }
+}
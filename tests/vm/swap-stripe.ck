@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-stripe) begin
+(swap-stripe) write page 0
+(swap-stripe) write page 1024
+(swap-stripe) write page 2048
+(swap-stripe) write page 3072
+(swap-stripe) write page 4096
+(swap-stripe) check page 0
+(swap-stripe) check page 1024
+(swap-stripe) check page 2048
+(swap-stripe) check page 3072
+(swap-stripe) check page 4096
+(swap-stripe) check page 0
+(swap-stripe) check page 1024
+(swap-stripe) check page 2048
+(swap-stripe) check page 3072
+(swap-stripe) check page 4096
+(swap-stripe) end
+EOF
+pass;
@@ -31,12 +31,22 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/pageout.h"
+#include "vm/ksm.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #include "filesys/directory.h"
+#include "filesys/page_cache.h"
+#include "filesys/buffer_cache.h"
+#include "filesys/journal.h"
+#include "filesys/dcache.h"
+#include "filesys/inode.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 #endif
 
 /* Page-map-level-4 with kernel mappings only. */
@@ -157,7 +167,8 @@ paging_init (uint64_t mem_end) {
 	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
 		uint64_t va = (uint64_t) ptov(pa);
 
-		perm = PTE_P | PTE_W;
+		// 커널 매핑은 모든 주소 공간에 똑같으므로 global: CR3를 바꿔도 TLB에 남음
+		perm = PTE_P | PTE_W | PTE_G;
 		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
 			perm &= ~PTE_W;
 
@@ -167,6 +178,7 @@ paging_init (uint64_t mem_end) {
 
 	// reload cr3
 	pml4_activate(0);
+	pml4_enable_tlb_tags();
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -218,16 +230,30 @@ parse_options (char **argv) {
 #ifdef FILESYS
 		else if (!strcmp (name, "-f"))
 			format_filesys = true;
+		else if (!strcmp (name, "-journal-crash"))
+			journal_crash = true;
 #endif
 		else if (!strcmp (name, "-rs"))
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-no-pcid"))
+			pcid_disabled = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-pageout-low"))
+			pageout_low_wm = atoi (value);
+		else if (!strcmp (name, "-pageout-high"))
+			pageout_high_wm = atoi (value);
+		else if (!strcmp (name, "-ksm-pages"))
+			ksm_pages_per_pass = atoi (value);
+		else if (!strcmp (name, "-swap"))
+			swap_spec = value;
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -326,10 +352,25 @@ usage (void) {
 			"  -h                 Print this help message and power off.\n"
 			"  -q                 Power off VM after actions or on panic.\n"
 			"  -f                 Format file system disk during startup.\n"
+#ifdef FILESYS
+			"  -journal-crash     Power off leaving the last journal transaction\n"
+			"                     unwritten in place, as a crash would.\n"
+#endif
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -no-pcid           Flush the TLB on every address space switch.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -pageout-low=COUNT Wake the pageout daemon below COUNT free frames\n"
+			"                     (0 disables it).\n"
+			"  -pageout-high=COUNT Let the pageout daemon free up to COUNT frames.\n"
+			"  -ksm-pages=COUNT   Scan COUNT frames for identical pages every\n"
+			"                     100 ms (0 disables merging).\n"
+			"  -swap=CHAN:DEV[:PRIO[:SECTOR]],...\n"
+			"                     Swap to these disks from SECTOR on, higher PRIO\n"
+			"                     first; stripe over equal PRIO (default 1:1).\n"
 #endif
 			);
 	power_off ();
@@ -358,10 +399,23 @@ print_stats (void) {
 	thread_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
+	buffer_cache_print_stats ();
+	page_cache_print_stats ();
+	inode_print_stats ();
+	dcache_print_stats ();
+#ifdef EFILESYS
+	fat_print_stats ();
+	journal_print_stats ();
+#endif
 #endif
 	console_print_stats ();
 	kbd_print_stats ();
+	pml4_print_stats ();
 #ifdef USERPROG
 	exception_print_stats ();
+	syscall_print_stats ();
+#endif
+#ifdef VM
+	vm_print_stats ();
 #endif
 }
@@ -1,17 +1,129 @@
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* Number of 2 MB mappings broken up into 4 KB pages. */
+static long long huge_split_cnt;
+
+/* pml4_clear_range() calls, page tables they freed, and how their
+ * invalidations were done. */
+static long long clear_range_cnt;
+static long long table_free_cnt;
+static long long tlb_single_cnt;
+static long long tlb_full_cnt;
+
+/* Process-context identifiers.
+ *
+ * With CR4.PCIDE set, every TLB entry is tagged with the PCID that
+ * was in CR3 when it was loaded, so switching back to an address
+ * space can keep its entries instead of refilling the TLB.  PCID 0
+ * belongs to base_pml4, whose user half is empty; the others are
+ * handed out round-robin to user pml4s on activation.  A pml4 that
+ * changes while another one is loaded cannot use invlpg, so it is
+ * marked stale and its entries are flushed when it is loaded next.
+ * Kernel mappings are global and survive every CR3 load either way. */
+#define PCID_CNT 64
+#define CR3_NOFLUSH (1ULL << 63)
+#define CR4_PGE (1 << 7)
+#define CR4_PCIDE (1 << 17)
+#define CPUID_ECX_PCID (1 << 17)
+
+bool pcid_disabled;
+static bool pcid_enabled;
+static uint64_t *pcid_owner[PCID_CNT];  /* pml4 using each PCID. */
+static bool pcid_stale[PCID_CNT];       /* Entries may be out of date. */
+static unsigned pcid_next = 1;          /* Next PCID to hand out. */
+
+/* CR3 loads, those that kept the TLB, PCIDs taken from a live pml4,
+ * and TSC cycles spent in the loads themselves. */
+static long long cr3_load_cnt;
+static long long cr3_noflush_cnt;
+static long long pcid_recycle_cnt;
+static uint64_t cr3_load_cycles;
+
+/* Returns true if PML4 is loaded in CR3. */
+static bool
+pml4_is_active (uint64_t *pml4) {
+	return PTE_ADDR (rcr3 ()) == vtop (pml4);
+}
+
+/* Returns PML4's PCID slot, or 0 if it has none. */
+static unsigned
+pcid_lookup (uint64_t *pml4) {
+	for (unsigned pcid = 1; pcid < PCID_CNT; pcid++)
+		if (pcid_owner[pcid] == pml4)
+			return pcid;
+	return 0;
+}
+
+/* Invalidates the TLB entry for VA after PML4's mapping of it
+ * changed.  Callers disable interrupts so that PML4 cannot be
+ * loaded between the change and this call. */
+static void
+tlb_flush_page (uint64_t *pml4, uint64_t va) {
+	if (pml4_is_active (pml4))
+		invlpg (va);
+	else if (pcid_enabled) {
+		unsigned pcid = pcid_lookup (pml4);
+		if (pcid != 0)
+			pcid_stale[pcid] = true;
+	}
+}
+
+/* Replaces the 2 MB mapping in PDE, which covers VA, with a page
+ * table that maps the same frames 4 KB at a time with the same
+ * permission, accessed and dirty bits.  Returns false if no page
+ * table could be allocated. */
+static bool
+pde_split (uint64_t *pde, const uint64_t va) {
+	uint64_t *pt = palloc_get_page (0);
+	if (pt == NULL)
+		return false;
+
+	uint64_t pa = PTE_ADDR (*pde) & ~(uint64_t) HPGMASK;
+	uint64_t flags = *pde & (PTE_P | PTE_W | PTE_U | PTE_A | PTE_D);
+	for (unsigned i = 0; i < PGSIZE / sizeof (uint64_t *); i++)
+		pt[i] = (pa + (uint64_t) i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+
+	/* Flushes the 2 MB TLB entry if PDE belongs to the active pml4;
+	 * otherwise it is gone by the time that pml4 is loaded. */
+	invlpg (va);
+	huge_split_cnt++;
+	return true;
+}
+
+/* Returns the page directory entry for VA in PML4 if it maps a
+ * 2 MB page, otherwise a null pointer. */
+static uint64_t *
+huge_pde (uint64_t *pml4, const uint64_t va) {
+	if (pml4 == NULL || !(pml4[PML4 (va)] & PTE_P))
+		return NULL;
+	uint64_t *pdp = ptov (PTE_ADDR (pml4[PML4 (va)]));
+	if (!(pdp[PDPE (va)] & PTE_P))
+		return NULL;
+	uint64_t *pd = ptov (PTE_ADDR (pdp[PDPE (va)]));
+	uint64_t *pde = &pd[PDX (va)];
+	return (*pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS) ? pde : NULL;
+}
+
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
 	if (pdp) {
+		/* A 2 MB page has no page table; make one if a 4 KB
+		 * entry is needed. */
+		if ((pdp[idx] & PTE_P) && (pdp[idx] & PTE_PS)
+				&& !(create && pde_split (&pdp[idx], va)))
+			return NULL;
 		uint64_t *pte = (uint64_t *) pdp[idx];
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
@@ -122,6 +234,8 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
+		if (pdp[i] & PTE_PS)
+			continue;
 		if (((uint64_t) pte) & PTE_P)
 			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
 					pml4_index, pdp_index, i))
@@ -169,6 +283,10 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
+		/* Frames of a 2 MB page belong to the frame table, which
+		 * frees them one 4 KB page at a time. */
+		if (pdp[i] & PTE_PS)
+			continue;
 		if (((uint64_t) pte) & PTE_P)
 			pt_destroy (PTE_ADDR (pte));
 	}
@@ -196,14 +314,87 @@ pml4_destroy (uint64_t *pml4) {
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
 	if (((uint64_t) pdpe) & PTE_P)
 		pdpe_destroy ((void *) PTE_ADDR (pdpe));
+
+	/* A new pml4 may get the same page, so give up the PCID; its
+	 * next owner starts with a flush. */
+	enum intr_level old_level = intr_disable ();
+	unsigned pcid = pcid_lookup (pml4);
+	if (pcid != 0)
+		pcid_owner[pcid] = NULL;
+	intr_set_level (old_level);
 	palloc_free_page ((void *) pml4);
 }
 
+/* Returns the CR3 value that loads PML4 under its PCID, assigning one
+ * if needed.  Sets the no-flush bit unless the PCID's TLB entries may
+ * be out of date. */
+static uint64_t
+pcid_cr3 (uint64_t *pml4) {
+	if (pml4 == NULL)
+		return vtop (base_pml4) | CR3_NOFLUSH;
+
+	unsigned pcid = pcid_lookup (pml4);
+	if (pcid == 0) {
+		pcid = pcid_next;
+		pcid_next = pcid_next % (PCID_CNT - 1) + 1;
+		if (pcid_owner[pcid] != NULL)
+			pcid_recycle_cnt++;
+		// 이전 주인의 TLB 항목이 남아 있으므로 처음 올릴 때는 비움
+		pcid_owner[pcid] = pml4;
+		pcid_stale[pcid] = true;
+	}
+
+	uint64_t cr3 = vtop (pml4) | pcid;
+	if (pcid_stale[pcid])
+		pcid_stale[pcid] = false;
+	else
+		cr3 |= CR3_NOFLUSH;
+	return cr3;
+}
+
 /* Loads page directory PD into the CPU's page directory base
  * register. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	enum intr_level old_level = intr_disable ();
+	uint64_t cr3 = pcid_enabled ? pcid_cr3 (pml4)
+		: vtop (pml4 ? pml4 : base_pml4);
+	uint64_t begin = rdtsc ();
+
+	lcr3 (cr3);
+	cr3_load_cycles += rdtsc () - begin;
+	cr3_load_cnt++;
+	if (cr3 & CR3_NOFLUSH)
+		cr3_noflush_cnt++;
+	intr_set_level (old_level);
+}
+
+/* Turns on global pages and, if the CPU has them and -no-pcid was not
+ * given, PCIDs.  Called once base_pml4 is loaded. */
+void
+pml4_enable_tlb_tags (void) {
+	uint64_t cr4 = rcr4 () | CR4_PGE;
+
+	/* CR4.PCIDE may only be set while the PCID in CR3 is 0, which
+	 * holds for base_pml4 loaded without one. */
+	if (!pcid_disabled && (cpuid_ecx (1) & CPUID_ECX_PCID)) {
+		cr4 |= CR4_PCIDE;
+		pcid_enabled = true;
+	}
+	lcr4 (cr4);
+}
+
+/* Prints address space switch and unmap statistics. */
+void
+pml4_print_stats (void) {
+	printf ("CR3: %lld loads, %lld kept the TLB (PCIDs %s), "
+			"%lld PCIDs recycled, %llu cycles per load\n",
+			cr3_load_cnt, cr3_noflush_cnt, pcid_enabled ? "on" : "off",
+			pcid_recycle_cnt,
+			cr3_load_cnt > 0 ? cr3_load_cycles / cr3_load_cnt : 0);
+	printf ("Unmap: %lld ranges, %lld page tables freed, "
+			"%lld pages invalidated singly, %lld full flushes\n",
+			clear_range_cnt, table_free_cnt, tlb_single_cnt, tlb_full_cnt);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -214,6 +405,11 @@ void *
 pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	ASSERT (is_user_vaddr (uaddr));
 
+	uint64_t *pde = huge_pde (pml4, (uint64_t) uaddr);
+	if (pde)
+		return ptov (PTE_ADDR (*pde) & ~(uint64_t) HPGMASK)
+			+ ((uint64_t) uaddr & HPGMASK);
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
@@ -243,6 +439,57 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	return pte != NULL;
 }
 
+/* Maps the 2 MB of user virtual memory at UPAGE to the physically
+ * contiguous frames at KPAGE with a single page directory entry.
+ * Both must be 2 MB aligned, and no 4 KB page in the range may be
+ * mapped.  The mapping is split back into 4 KB pages as soon as any
+ * one of them is unmapped or remapped.
+ * Returns false if part of the range is mapped or memory allocation
+ * failed. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT (((uint64_t) upage & HPGMASK) == 0);
+	ASSERT ((vtop (kpage) & HPGMASK) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	uint64_t va = (uint64_t) upage;
+	uint64_t *table = pml4;
+	unsigned idx[] = { PML4 (va), PDPE (va) };
+	for (unsigned level = 0; level < 2; level++) {
+		if (!(table[idx[level]] & PTE_P)) {
+			uint64_t *new_page = palloc_get_page (PAL_ZERO);
+			if (new_page == NULL)
+				return false;
+			table[idx[level]] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		table = ptov (PTE_ADDR (table[idx[level]]));
+	}
+
+	uint64_t *pde = &table[PDX (va)];
+	if (*pde & PTE_P) {
+		if (*pde & PTE_PS)
+			return false;
+		uint64_t *pt = ptov (PTE_ADDR (*pde));
+		for (unsigned i = 0; i < PGSIZE / sizeof (uint64_t *); i++)
+			if (pt[i] & PTE_P)
+				return false;
+		palloc_free_page (pt);
+	}
+	/* The freed page table may still be cached for VA. */
+	enum intr_level old_level = intr_disable ();
+	*pde = vtop (kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	tlb_flush_page (pml4, va);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Returns the number of 2 MB mappings split into 4 KB pages. */
+long long
+pml4_huge_split_cnt (void) {
+	return huge_split_cnt;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -253,22 +500,176 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (is_user_vaddr (upage));
 
+	uint64_t *pde = huge_pde (pml4, (uint64_t) upage);
+	if (pde != NULL && !pde_split (pde, (uint64_t) upage))
+		PANIC ("pml4_clear_page: cannot split 2 MB page");
+
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
+		enum intr_level old_level = intr_disable ();
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		tlb_flush_page (pml4, (uint64_t) upage);
+		intr_set_level (old_level);
 	}
 }
 
+/* Range unmapping.
+ *
+ * pml4_clear_range() walks the tables once for a whole region instead
+ * of once per page, and gives back page tables that end up empty as it
+ * goes.  Invalidations are collected while interrupts are off: up to
+ * TLB_BATCH_MAX pages are flushed one by one, and a larger range
+ * reloads CR3, which drops every non-global entry of the address space
+ * for about the cost of a few invlpgs. */
+#define TLB_BATCH_MAX 32
+
+struct tlb_batch {
+	uint64_t *pml4;
+	size_t cnt;                     /* Entries removed so far. */
+	uint64_t va[TLB_BATCH_MAX];     /* Addresses of the first ones. */
+	uint64_t *freed;                /* Detached tables, linked through
+	                                   their first entry. */
+};
+
+static void
+tlb_batch_add (struct tlb_batch *b, uint64_t va) {
+	if (b->cnt < TLB_BATCH_MAX)
+		b->va[b->cnt] = va;
+	b->cnt++;
+}
+
+/* Flushes everything added to B from the TLB and from the paging
+ * structure caches, which may still point at the detached tables. */
+static void
+tlb_batch_flush (struct tlb_batch *b) {
+	if (b->cnt == 0)
+		return;
+	if (!pml4_is_active (b->pml4))
+		tlb_flush_page (b->pml4, b->va[0]);
+	else if (b->cnt > TLB_BATCH_MAX) {
+		/* Bit 63 reads as 0, so this flushes the current PCID. */
+		lcr3 (rcr3 ());
+		tlb_full_cnt++;
+	} else {
+		for (size_t i = 0; i < b->cnt; i++)
+			invlpg (b->va[i]);
+		tlb_single_cnt += b->cnt;
+	}
+}
+
+static bool
+table_is_empty (const uint64_t *table) {
+	for (unsigned i = 0; i < PGSIZE / sizeof (uint64_t *); i++)
+		if (table[i] != 0)
+			return false;
+	return true;
+}
+
+/* Detaches the table that *ENTRY, which maps VA, points to and queues
+ * it in B to be freed after the flush.  The link is page aligned, so
+ * to a stale walk the entry it overwrites still reads as not present. */
+static void
+table_retire (struct tlb_batch *b, uint64_t *entry, uint64_t va) {
+	uint64_t *table = ptov (PTE_ADDR (*entry));
+
+	*entry = 0;
+	table[0] = (uint64_t) b->freed;
+	b->freed = table;
+	tlb_batch_add (b, va);
+	table_free_cnt++;
+}
+
+/* Zeroes the entries of TABLE, a paging structure LEVEL levels above
+ * the page tables, that map [VA, END), descending into lower tables
+ * and retiring the ones that become empty.  Entries that are merely
+ * not present keep a table alive, since a page being evicted still
+ * needs its dirty bit.  Returns true if TABLE maps nothing any more. */
+static bool
+table_clear_range (uint64_t *table, unsigned level, uint64_t va,
+		uint64_t end, struct tlb_batch *b) {
+	unsigned shift = PTXSHIFT + 9 * level;
+	uint64_t span = 1ULL << shift;
+
+	for (unsigned i = (va >> shift) & 0x1FF;
+			i < PGSIZE / sizeof (uint64_t *) && va < end; i++) {
+		uint64_t next = (va & ~(span - 1)) + span;
+		uint64_t *entry = &table[i];
+
+		if (level == 0 || (*entry & PTE_PS)) {
+			/* Both ends of the range were split, so a 2 MB entry
+			 * here lies wholly inside it. */
+			if (*entry & PTE_P)
+				tlb_batch_add (b, va);
+			*entry = 0;
+		} else if ((*entry & PTE_P)
+				&& table_clear_range (ptov (PTE_ADDR (*entry)), level - 1,
+					va, end, b))
+			table_retire (b, entry, va);
+		va = next;
+	}
+	return table_is_empty (table);
+}
+
+/* Splits the 2 MB mapping around VA if the range boundary VA falls
+ * inside it. */
+static void
+split_huge_edge (uint64_t *pml4, uint64_t va) {
+	uint64_t *pde = huge_pde (pml4, va);
+	if ((va & HPGMASK) != 0 && pde != NULL && !pde_split (pde, va))
+		PANIC ("pml4_clear_range: cannot split 2 MB page");
+}
+
+/* Unmaps every user page in [START, END) from PML4 in one walk and
+ * frees the page tables left empty.  Unlike pml4_clear_page(), the
+ * entries are zeroed, so their dirty and accessed bits must be read
+ * beforehand.  Frames are not freed; they belong to whoever mapped
+ * them. */
+void
+pml4_clear_range (uint64_t *pml4, void *start, void *end) {
+	ASSERT (pg_ofs (start) == 0);
+	ASSERT (pg_ofs (end) == 0);
+	ASSERT ((uint64_t) end <= KERN_BASE);
+
+	if (pml4 == NULL)
+		return;
+	ASSERT (pml4 != base_pml4);
+
+	/* As in pml4_destroy(), user pages live under pml4[0]; the next
+	 * entry is shared with the kernel. */
+	uint64_t lo = (uint64_t) start;
+	uint64_t hi = (uint64_t) end;
+	if (hi > 1ULL << PML4SHIFT)
+		hi = 1ULL << PML4SHIFT;
+	if (lo >= hi)
+		return;
+
+	split_huge_edge (pml4, lo);
+	split_huge_edge (pml4, hi);
+
+	struct tlb_batch b = { .pml4 = pml4 };
+	enum intr_level old_level = intr_disable ();
+	table_clear_range (pml4, 3, lo, hi, &b);
+	tlb_batch_flush (&b);
+	intr_set_level (old_level);
+
+	while (b.freed != NULL) {
+		uint64_t *table = b.freed;
+		b.freed = (uint64_t *) table[0];
+		palloc_free_page (table);
+	}
+	clear_range_cnt++;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 is dirty,
  * that is, if the page has been modified since the PTE was
  * installed.
  * Returns false if PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_dirty (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = huge_pde (pml4, (uint64_t) vpage);
+	if (pte == NULL)
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	return pte != NULL && (*pte & PTE_D) != 0;
 }
 
@@ -276,25 +677,31 @@ pml4_is_dirty (uint64_t *pml4, const void *vpage) {
  * in PML4. */
 void
 pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = huge_pde (pml4, (uint64_t) vpage);
+	if (pte == NULL)
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	if (pte) {
+		enum intr_level old_level = intr_disable ();
 		if (dirty)
 			*pte |= PTE_D;
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_flush_page (pml4, (uint64_t) vpage);
+		intr_set_level (old_level);
 	}
 }
 
 /* Returns true if the PTE for virtual page VPAGE in PML4 has been
  * accessed recently, that is, between the time the PTE was
  * installed and the last time it was cleared.  Returns false if
- * PML4 contains no PTE for VPAGE. */
+ * PML4 contains no PTE for VPAGE.  Pages inside a 2 MB mapping
+ * share the accessed and dirty bits of its page directory entry. */
 bool
 pml4_is_accessed (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = huge_pde (pml4, (uint64_t) vpage);
+	if (pte == NULL)
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	return pte != NULL && (*pte & PTE_A) != 0;
 }
 
@@ -302,14 +709,19 @@ pml4_is_accessed (uint64_t *pml4, const void *vpage) {
    VPAGE in PD. */
 void
 pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = huge_pde (pml4, (uint64_t) vpage);
+	if (pte == NULL)
+		pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	if (pte) {
 		if (accessed)
 			*pte |= PTE_A;
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
+		/* A stale entry in another address space only keeps the
+		 * CPU from setting the bit again, which costs the clock some
+		 * accuracy but nothing else, so no flush is forced for it. */
+		if (pml4_is_active (pml4))
 			invlpg ((uint64_t) vpage);
 	}
 }
@@ -2,6 +2,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "intrinsic.h"
@@ -9,8 +10,12 @@
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+/* Number of kernel faults on user memory resumed at a fixup. */
+static long long fixup_cnt;
+
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
+static bool fixup_exception (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -64,6 +69,7 @@ exception_init (void) {
 void
 exception_print_stats (void) {
 	printf ("Exception: %lld page faults\n", page_fault_cnt);
+	printf ("Exception: %lld user copy faults fixed up\n", fixup_cnt);
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -145,6 +151,9 @@ page_fault (struct intr_frame *f) {
 	if (vm_try_handle_fault (f, fault_addr, user, write, not_present))
 		return;
 #endif
+	/* 커널이 유저 메모리를 복사하다 난 fault면 fixup으로 돌아가 실패를 반환하게 함 */
+	if (!user && fixup_exception (f))
+		return;
 	exit (-1);
 
 	/* Count page faults. */
@@ -159,3 +168,19 @@ page_fault (struct intr_frame *f) {
 	kill (f);
 }
 
+/* If the instruction at F's rip is listed in the exception table,
+   resumes F at its fixup and returns true.  Only the user copy
+   primitives in userprog/uaccess.c have entries. */
+static bool
+fixup_exception (struct intr_frame *f) {
+	extern struct exception_entry _start_ex_table[], _end_ex_table[];
+	struct exception_entry *e;
+
+	for (e = _start_ex_table; e < _end_ex_table; e++)
+		if (e->insn == f->rip) {
+			f->rip = e->fixup;
+			fixup_cnt++;
+			return true;
+		}
+	return false;
+}
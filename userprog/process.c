@@ -20,6 +20,7 @@
 #include "intrinsic.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/launch.h"
 #endif
 #ifdef EFILESYS
 #include "filesys/directory.h"
@@ -217,6 +218,8 @@ __do_fork (void *aux) {
 
 	process_activate (current);
 #ifdef VM
+	// RSS 상한은 fork와 exec를 거쳐도 유지됨
+	current->rss_limit = parent->rss_limit;
 	supplemental_page_table_init (&current->spt);
 	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
 		goto error;
@@ -396,6 +399,7 @@ process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
 #ifdef VM
+	launch_finish (curr);
 	if(!hash_empty(&curr->spt.pages))
 		supplemental_page_table_kill (&curr->spt);
 #endif
@@ -515,6 +519,10 @@ static bool load (const char *file_name, struct intr_frame *if_) {
 	// 현재 실행 중인 파일의 경우 write할 수 없도록 설정
 	t->running = file;
 	file_deny_write(file);
+#ifdef VM
+	// 이전 실행에서 기록한 fault 순서대로 미리 읽기 시작 (없으면 이번 실행을 기록)
+	launch_start(file);
+#endif
 
 	/* Read and verify executable header. */
 	// ELF파일 헤더 정보를 읽어와 저장
@@ -768,6 +776,7 @@ bool lazy_load_segment (struct page *page, void *aux) {
 	size_t page_read_bytes = ((struct container *)aux)->page_read_bytes;
     size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+	launch_record(page, offsetof);
 	file_seek(file, offsetof);
 
     if (file_read(file, page->frame->kva, page_read_bytes) != (int)page_read_bytes) {
@@ -809,6 +818,15 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		/* TODO: Set up aux(container로 대체) to pass information to the lazy_load_segment. */
 		// struct container *container;
 		// container = palloc_get_page(PAL_ZERO | PAL_USER);
+		// 파일에서 읽을 내용이 없는 페이지(bss)는 initializer 없이 만들어 첫 읽기에 zero page를 매핑
+		if (page_read_bytes == 0) {
+			if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, NULL, NULL))
+				return false;
+			zero_bytes -= page_zero_bytes;
+			upage += PGSIZE;
+			continue;
+		}
+
 		struct container *container = (struct container *)malloc(sizeof(struct container));
 		container->file = file;
 		container->page_read_bytes = page_read_bytes;
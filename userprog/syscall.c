@@ -12,18 +12,22 @@
 #include <list.h>
 #include <stdio.h>
 #include <syscall-nr.h>
+#include <mman.h>
 #include "intrinsic.h"
+#include "userprog/uaccess.h"
 #include "vm/vm.h"
+#include "vm/advise.h"
+#include "vm/launch.h"
 
 #include "filesys/directory.h"
 #include "filesys/fat.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
 const int STDIN = 1;
 const int STDOUT = 2;
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
-struct page * check_address(void *addr);
-void check_valid_buffer(void* buffer, unsigned size, void* rsp, bool to_write);
+static char *copy_in_string(const char *ustr);
 int add_file_to_fdt(struct file *file);
 void remove_file_from_fdt(int fd);
 static struct file *find_file_by_fd(int fd);
@@ -44,6 +48,12 @@ void close(int fd);
 
 void* mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+bool msync (void *addr, size_t length);
+bool madvise (void *addr, size_t length, int advice);
+#ifdef VM
+void setrss (size_t pages);
+size_t getrss (void);
+#endif
 
 // Project 4-2. Subdirectory
 bool chdir (const char *dir_input);
@@ -68,6 +78,14 @@ int symlink (const char* target, const char* linkpath);
 
 struct lock file_rw_lock;
 
+// read/write 벤치마크용 통계: 호출 수, 바이트 수, 걸린 TSC cycle
+struct rw_stats {
+	long long calls;
+	long long bytes;
+	long long cycles;
+};
+static struct rw_stats read_stats, write_stats;
+
 void
 syscall_init (void) {
 	lock_init (&file_rw_lock);
@@ -86,6 +104,10 @@ syscall_init (void) {
 void
 syscall_handler (struct intr_frame *f UNUSED) {
 	// TODO: Your implementation goes here.
+#ifdef VM
+	// 커널 모드에서 난 page fault의 stack growth 판단에 쓰는 유저 rsp
+	thread_current()->rsp_stack = (void *) f->rsp;
+#endif
 	switch (f->R.rax)
 	{
 		case SYS_HALT:
@@ -148,15 +170,21 @@ syscall_handler (struct intr_frame *f UNUSED) {
 			
 		case SYS_READ:
 		{
-		check_valid_buffer(f->R.rsi, f->R.rdx, f->rsp, 1);
+		uint64_t begin = rdtsc();
 		f->R.rax = read(f->R.rdi, f->R.rsi, f->R.rdx);
+		read_stats.calls++;
+		read_stats.bytes += (int) f->R.rax > 0 ? (int) f->R.rax : 0;
+		read_stats.cycles += rdtsc() - begin;
 		break;
 		}
 		
 		case SYS_WRITE:
 		{
-		check_valid_buffer(f->R.rsi, f->R.rdx, f->rsp, 0);
+		uint64_t begin = rdtsc();
 		f->R.rax = write(f->R.rdi, f->R.rsi, f->R.rdx);
+		write_stats.calls++;
+		write_stats.bytes += (int) f->R.rax > 0 ? (int) f->R.rax : 0;
+		write_stats.cycles += rdtsc() - begin;
 		break;
 		}
 
@@ -190,6 +218,36 @@ syscall_handler (struct intr_frame *f UNUSED) {
 			break;
 		}
 
+		case SYS_MSYNC:
+		{
+			f->R.rax = msync(f->R.rdi, f->R.rsi);
+			break;
+		}
+
+		case SYS_MADVISE:
+		{
+			f->R.rax = madvise(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		}
+
+		case SYS_SETRSS:
+		{
+#ifdef VM
+			setrss(f->R.rdi);
+#endif
+			break;
+		}
+
+		case SYS_GETRSS:
+		{
+#ifdef VM
+			f->R.rax = getrss();
+#else
+			f->R.rax = -1;  // VM 없이는 rss를 세지 않음
+#endif
+			break;
+		}
+
 		case SYS_CHDIR:
 		{
 			f->R.rax = chdir(f->R.rdi);
@@ -255,21 +313,27 @@ void halt(void)
 bool create(const char *filename, unsigned initial_size) 
 {
 	bool return_code;
-	check_address(filename);
+	char *kname = copy_in_string(filename);
+	if (kname == NULL)
+		return false;
 
 	// lock_acquire(&filesys_lock); 
-	return_code = filesys_create(filename, initial_size);
+	return_code = filesys_create(kname, initial_size);
 	// lock_release (&filesys_lock);
+	palloc_free_page(kname);
 	return return_code;
 }
 
 bool remove(const char *filename)
 {
 	bool return_code;
-	check_address(filename);
+	char *kname = copy_in_string(filename);
+	if (kname == NULL)
+		return false;
 	// lock_acquire(&filesys_lock);
-	return_code = filesys_remove(filename);
+	return_code = filesys_remove(kname);
 	// lock_release(&filesys_lock);
+	palloc_free_page(kname);
 	return return_code;
 }
 
@@ -278,17 +342,13 @@ bool remove(const char *filename)
 // 함수의 리턴값도 int 가 아닌 pid_t 임. 고민 해야함. 
 int exec(char *cmdline)
 {
-	check_address(cmdline);
-
 	// process_exec 의 process_cleanup때문에 f->R.rdi 가 날아간다는데 
 	// process cleanup의 대상은 f (intr_frame) 가 아니지 않나?
 	// 현재 진행중인 프로세스에서 context switching을 하는 역할인데. 
-	int file_size = strlen(cmdline) + 1;
-	char *cmd_copy = palloc_get_page(PAL_ZERO);
+	char *cmd_copy = copy_in_string(cmdline);
 	if (cmd_copy == NULL) {
 		exit(-1);
 	}
-	strlcpy(cmd_copy, cmdline, file_size);
 
 	if (process_exec(cmd_copy) == -1) {
 		return -1;
@@ -303,56 +363,113 @@ tid_t fork(const char *thread_name, struct intr_frame *f) {
 } 
 
 // 인자로 넣어주는 fd가 내가 쓰고싶은 파일. buffer에 쓸 내용 넣어서 전달.
+// 유저 버퍼는 한 페이지씩 커널 bounce buffer로 복사해서 처리.
+// 잘못된 주소는 복사 중 fault -> fixup으로 감지하고 프로세스를 종료함
 int write(int fd, const void *buffer, unsigned size) {
-	check_address(buffer);
-	int write_result;
+	if (buffer == NULL || !user_range_ok(buffer, size))
+		exit(-1);
+	int write_result = 0;
 	struct file *fileobj = find_file_by_fd(fd);
 	if (fileobj == NULL) {
 		return -1;
 	}
-	struct thread *cur = thread_current();
-	if (fd == 1) {
-		putbuf(buffer, size);  // 표준출력을 처리하는 함수 putbuf()
-		write_result = size;
-	} else if (fd == 0) {
-		write_result = -1;
-	} else {
-		if (inode_isdir(fileobj->inode)) {
-			return -1;
-		}
+	if (fd == 0) {
+		return -1;
+	}
+	if (fd != 1 && inode_isdir(fileobj->inode)) {
+		return -1;
+	}
+
+	char *kbuf = palloc_get_page(0);
+	if (kbuf == NULL)
+		return -1;
+	// chunk 사이에 다른 writer가 끼어들지 않도록 write 전체에 걸쳐 잡음
+	if (fd != 1)
 		lock_acquire(&file_rw_lock);
-		write_result = file_write(fileobj, buffer, size);
-		lock_release(&file_rw_lock);
+	while ((unsigned) write_result < size) {
+		size_t chunk = size - write_result < PGSIZE ? size - write_result : PGSIZE;
+		int written;
+
+		if (!copy_from_user(kbuf, buffer + write_result, chunk)) {
+			if (fd != 1)
+				lock_release(&file_rw_lock);
+			palloc_free_page(kbuf);
+			exit(-1);
+		}
+		if (fd == 1) {
+#ifdef VM
+			launch_first_output();  // exec부터 첫 출력까지 걸린 시간 측정
+#endif
+			putbuf(kbuf, chunk);  // 표준출력을 처리하는 함수 putbuf()
+			written = chunk;
+		} else
+			written = file_write(fileobj, kbuf, chunk);
+		write_result += written;
+		if ((size_t) written < chunk)
+			break;
 	}
+	if (fd != 1)
+		lock_release(&file_rw_lock);
+	palloc_free_page(kbuf);
 	return write_result;
 }
 
 int read(int fd, void *buffer, unsigned size) {
-	check_address(buffer);
-	int read_result;
-	struct thread *cur = thread_current();
+	if (buffer == NULL || !user_range_ok(buffer, size))
+		exit(-1);
+	int read_result = 0;
 	struct file *file_fd = find_file_by_fd(fd);
 	if (file_fd == NULL) {
 		return -1;
 	}
-	if (fd == 0) {
-		int i;
-		unsigned char *buf = buffer;
-		for (i = 0; i < size; i++) {
-			char c = input_getc();
-			*buf++ = c;
-			if (c == '\0') {
-				break;
+	if (fd == 1) {
+		return -1;
+	}
+
+	char *kbuf = palloc_get_page(0);
+	if (kbuf == NULL)
+		return -1;
+	// write와 마찬가지로 read 전체가 한 번의 write와 섞이지 않게 함
+	if (fd != 0)
+		lock_acquire(&file_rw_lock);
+	while ((unsigned) read_result < size) {
+		size_t chunk = size - read_result < PGSIZE ? size - read_result : PGSIZE;
+		int n;
+
+		if (fd == 0) {
+			bool eol = false;
+			for (n = 0; (size_t) n < chunk && !eol; n++) {
+				kbuf[n] = input_getc();
+				eol = kbuf[n] == '\0';
+			}
+			// 기존처럼 '\0'은 버퍼에 넣지만 읽은 길이에는 세지 않음
+			if (eol)
+				n--;
+			if (!copy_to_user(buffer + read_result, kbuf, n + eol)) {
+				palloc_free_page(kbuf);
+				exit(-1);
 			}
+			read_result += n;
+			if (eol)
+				break;
+			continue;
 		}
-		read_result = i;
-	} else if (fd == 1) {
-		read_result = -1;
-	} else {
-		lock_acquire(&file_rw_lock);
-		read_result = file_read(file_fd, buffer, size);
-		lock_release(&file_rw_lock);
+
+		n = file_read(file_fd, kbuf, chunk);
+		if (n > 0 && !copy_to_user(buffer + read_result, kbuf, n)) {
+			lock_release(&file_rw_lock);
+			palloc_free_page(kbuf);
+			exit(-1);
+		}
+		if (n <= 0)
+			break;
+		read_result += n;
+		if ((size_t) n < chunk)
+			break;
 	}
+	if (fd != 0)
+		lock_release(&file_rw_lock);
+	palloc_free_page(kbuf);
 	return read_result;
 } 
 // fd 인자를 받아서 파일 크기를 리턴
@@ -366,8 +483,11 @@ int filesize(int fd) {
 
 // fd 값 리턴, 실패시 -1 리턴. 파일 여는 함수
 int open(const char *file) {
-	check_address(file);
-	struct file *open_file = filesys_open(file);
+	char *kname = copy_in_string(file);
+	if (kname == NULL)
+		return -1;
+	struct file *open_file = filesys_open(kname);
+	palloc_free_page(kname);
 	if (open_file == NULL) {
 		return -1;
 	}
@@ -433,12 +553,16 @@ void close(int fd)
 
 // for VM
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
+    // MAP_POPULATE: 매핑 직후 prefetch thread가 페이지를 미리 읽어 둠
+    bool populate = (writable & MAP_POPULATE) != 0;
+    writable &= ~MAP_POPULATE;
 
     if (offset % PGSIZE != 0) {
         return NULL;
     }
 
-    if (pg_round_down(addr) != addr || is_kernel_vaddr(addr) || addr == NULL || (long long)length <= 0)
+    // 매핑할 범위 전체가 유저 영역 안에 있어야 함 (끝 주소가 커널로 넘어가는 경우 포함)
+    if (pg_round_down(addr) != addr || !user_range_ok(addr, length) || addr == NULL || (long long)length <= 0)
         return NULL;
     
     if (fd == 0 || fd == 1)
@@ -455,6 +579,8 @@ void *mmap (void *addr, size_t length, int writable, int fd, off_t offset) {
         return NULL;
 
     void * ret = do_mmap(addr, length, writable, target, offset);
+    if (ret != NULL && populate)
+        advise_prefetch(ret, length);
 
     return ret;
 }
@@ -463,6 +589,33 @@ void munmap (void *addr) {
     do_munmap(addr);
 }
 
+// 매핑된 파일 페이지 중 dirty한 것을 바로 파일에 기록
+bool msync (void *addr, size_t length) {
+    if (addr == NULL || pg_ofs(addr) != 0 || is_kernel_vaddr(addr)
+            || is_kernel_vaddr(addr + length) || addr + length < addr)
+        return false;
+    return do_msync(addr, length);
+}
+
+// 범위 안 페이지들의 접근 패턴 힌트를 기록하거나 미리 읽기/반납
+bool madvise (void *addr, size_t length, int advice) {
+    if (addr == NULL || pg_ofs(addr) != 0 || !user_range_ok(addr, length))
+        return false;
+    return do_madvise(addr, length, advice);
+}
+
+#ifdef VM
+// 이 프로세스가 가질 수 있는 frame 수를 제한 (0이면 제한 없음). 넘으면 자기 페이지부터 쫓아냄
+void setrss (size_t pages) {
+    vm_set_rss_limit(pages);
+}
+
+// 이 프로세스가 가진 private frame 수
+size_t getrss (void) {
+    return thread_current()->rss;
+}
+#endif
+
 // Project 4-2. Subdirectory
 bool
 chdir (const char *dir_input) {
@@ -507,6 +660,7 @@ bool mkdir (const char *dir_input){
 	if(path->dircount==-1) {
 		return false;
 	}
+	journal_begin ();
 	struct dir* subdir = find_subdir(path->dirnames, path->dircount);
 	if(subdir == NULL) {
 		goto done;
@@ -536,6 +690,7 @@ bool mkdir (const char *dir_input){
 
 done: 
 	dir_close (subdir); //아마 중복으로 여는거 방지하려면 매번 close해줘야할듯
+	journal_end ();
 	free_path(path);
 
 	return success;
@@ -591,6 +746,7 @@ symlink (const char* target, const char* linkpath) {
 	}
 
 	//find target inode
+	journal_begin ();
 	struct inode* inode = NULL;
 	dir_lookup(subdir_tar, path_tar->filename, &inode);
 	if(inode == NULL) {
@@ -618,6 +774,7 @@ symlink (const char* target, const char* linkpath) {
 	free_path(path_link);
 	dir_close (subdir_tar);
 	free_path(path_tar);
+	journal_end ();
 	return 0;
 }
 
@@ -628,22 +785,34 @@ symlink (const char* target, const char* linkpath) {
 
 
 /*------------- project 2 helper function -------------- */
-// page에 맞게 check_address 수정
-struct page * check_address(void *addr) {
-    if (is_kernel_vaddr(addr) || addr == NULL) {
-        exit(-1);
-    }
-    return spt_find_page(&thread_current()->spt, addr);
+/* 유저 문자열을 커널 페이지로 복사해서 돌려준다 (caller가 palloc_free_page).
+ * 읽을 수 없는 주소면 프로세스를 종료하고, 한 페이지에 들어가지 않으면 NULL. */
+static char *
+copy_in_string(const char *ustr) {
+	char *kstr = palloc_get_page(0);
+	if (kstr == NULL)
+		return NULL;
+
+	long len = strncpy_from_user(kstr, ustr, PGSIZE);
+	if (len < 0) {
+		palloc_free_page(kstr);
+		exit(-1);
+	}
+	if (len == PGSIZE) {
+		palloc_free_page(kstr);
+		return NULL;
+	}
+	return kstr;
 }
 
-void check_valid_buffer(void* buffer, unsigned size, void* rsp, bool to_write) {
-    for (int i = 0; i < size; i++) {
-        struct page* page = check_address(buffer + i);    // 인자로 받은 buffer부터 buffer + size까지의 크기가 한 페이지의 크기를 넘을수도 있음
-        if(page == NULL)
-            exit(-1);
-        if(to_write == true && page->writable == false)
-            exit(-1);
-    }
+/* Prints read/write syscall statistics. */
+void
+syscall_print_stats (void) {
+	printf ("Syscall read: %lld calls, %lld bytes, %lld cycles\n",
+			read_stats.calls, read_stats.bytes, read_stats.cycles);
+	printf ("Syscall write: %lld calls, %lld bytes, %lld cycles\n",
+			write_stats.calls, write_stats.bytes, write_stats.cycles);
+	uaccess_print_stats ();
 }
 
 /* -----------Project 3 change -----------------*/
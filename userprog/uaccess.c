@@ -0,0 +1,104 @@
+/* uaccess.c: Copying between kernel and user memory.
+ *
+ * The copy instructions below are listed in the exception table (section
+ * .ex_table, see kernel.lds.S).  When one of them faults on a user address
+ * that the VM cannot resolve, page_fault() resumes execution at the fixup
+ * label instead of killing the process, and the primitive reports failure
+ * to its caller.  So a buffer is never walked byte by byte up front; only
+ * the range is checked against the user/kernel boundary. */
+
+#include "userprog/uaccess.h"
+#include <stdio.h>
+#include "threads/vaddr.h"
+
+// 통계: 유저에서 복사해 온 바이트 / 유저로 복사한 바이트
+static long long copy_in_bytes;
+static long long copy_out_bytes;
+
+/* Returns true if [UADDR, UADDR + SIZE) lies entirely below KERN_BASE. */
+bool
+user_range_ok (const void *uaddr, size_t size) {
+	uint64_t start = (uint64_t) uaddr;
+	return start + size >= start && start + size <= KERN_BASE;
+}
+
+/* Copies SIZE bytes from SRC to DST with `rep movsb'.  Returns the number
+ * of bytes left uncopied, which is nonzero only if a fault was fixed up. */
+static size_t
+copy_raw (void *dst, const void *src, size_t size) {
+	__asm __volatile (
+			"1: rep movsb\n"
+			"2:\n"
+			".pushsection .ex_table, \"a\"\n"
+			".balign 8\n"
+			".quad 1b, 2b\n"
+			".popsection\n"
+			: "+D" (dst), "+S" (src), "+c" (size)
+			:
+			: "memory");
+	return size;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel buffer DST.
+ * Returns false if part of the source is not readable user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size) {
+	if (!user_range_ok (usrc, size) || copy_raw (dst, usrc, size) != 0)
+		return false;
+	copy_in_bytes += size;
+	return true;
+}
+
+/* Copies SIZE bytes from kernel buffer SRC to user address UDST.
+ * Returns false if part of the destination is not writable user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size) {
+	if (!user_range_ok (udst, size) || copy_raw (udst, src, size) != 0)
+		return false;
+	copy_out_bytes += size;
+	return true;
+}
+
+/* Copies a null-terminated string from user address USRC into DST, which
+ * holds SIZE bytes.  Returns the length of the string, SIZE if it does not
+ * fit (DST is then not terminated), or -1 if USRC is not readable. */
+long
+strncpy_from_user (char *dst, const char *usrc, size_t size) {
+	long len;
+
+	if ((uint64_t) usrc >= KERN_BASE)
+		return -1;
+	// 커널 영역까지 읽어 내려가지 않도록 제한
+	if (size > KERN_BASE - (uint64_t) usrc)
+		size = KERN_BASE - (uint64_t) usrc;
+
+	__asm __volatile (
+			"   xor %[len], %[len]\n"
+			"1: cmp %[size], %[len]\n"
+			"   je 4f\n"
+			"2: movb (%[src], %[len]), %%al\n"
+			"   movb %%al, (%[dst], %[len])\n"
+			"   test %%al, %%al\n"
+			"   je 4f\n"
+			"   inc %[len]\n"
+			"   jmp 1b\n"
+			"3: mov $-1, %[len]\n"
+			"4:\n"
+			".pushsection .ex_table, \"a\"\n"
+			".balign 8\n"
+			".quad 2b, 3b\n"
+			".popsection\n"
+			: [len] "=&r" (len)
+			: [src] "r" (usrc), [dst] "r" (dst), [size] "r" (size)
+			: "rax", "memory", "cc");
+	if (len > 0)
+		copy_in_bytes += len;
+	return len;
+}
+
+/* Prints user copy statistics. */
+void
+uaccess_print_stats (void) {
+	printf ("User copy: %lld bytes in, %lld bytes out\n",
+			copy_in_bytes, copy_out_bytes);
+}
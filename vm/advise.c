@@ -0,0 +1,252 @@
+/* advise.c: Access pattern hints (madvise) and background prefetch.
+ *
+ * madvise() stores SEQUENTIAL, RANDOM or NORMAL in every page of the range.
+ * WILLNEED and mmap(MAP_POPULATE) queue the range for the prefetch thread,
+ * which claims the pages on behalf of their owner so that later accesses
+ * find them resident.  A fault on a SEQUENTIAL page queues the next
+ * RA_PAGES pages the same way and lets the clock take the page RA_PAGES
+ * behind it first.  DONTNEED hands frames and swap slots back right away. */
+
+#include <mman.h>
+#include <stdio.h>
+#include "vm/advise.h"
+#include "vm/vm.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* SEQUENTIAL 페이지에서 fault가 나면 미리 읽는 페이지 수 */
+#define RA_PAGES 8
+/* 처리를 기다리는 prefetch 요청의 최대 개수. 넘치면 새 요청은 버림 */
+#define PREFETCH_QUEUE_MAX 64
+
+/* [start, end) of OWNER's address space to prefetch. */
+struct prefetch_req {
+	struct thread *owner;
+	void *start;
+	void *end;
+	bool readahead;                 /* SEQUENTIAL fault에서 생긴 요청 */
+	struct list_elem elem;
+};
+
+static struct list prefetch_queue;
+static size_t prefetch_queued;
+static struct lock prefetch_lock;
+static struct condition prefetch_ready;     /* queue에 요청이 들어옴 */
+static struct condition prefetch_idle;      /* worker가 요청 하나를 끝냄 */
+static struct thread *prefetch_owner;       /* worker가 처리 중인 요청의 주인 */
+static bool prefetch_cancel;                /* 처리 중인 요청을 그만두라는 표시 */
+
+// 통계: WILLNEED/populate로 올린 페이지 / readahead로 올린 페이지 / DONTNEED로 버린 페이지
+static long long prefetch_cnt;
+static long long readahead_cnt;
+static long long dontneed_cnt;
+
+static void prefetch_worker (void *aux);
+
+/* Initializes the prefetch queue and starts the prefetch thread. */
+void
+vm_advise_init (void) {
+	list_init (&prefetch_queue);
+	lock_init (&prefetch_lock);
+	cond_init (&prefetch_ready);
+	cond_init (&prefetch_idle);
+	thread_create ("prefetch", PRI_DEFAULT, prefetch_worker, NULL);
+}
+
+/* Queues [START, END) of OWNER's address space for the prefetch thread. */
+static void
+prefetch_enqueue (struct thread *owner, void *start, void *end,
+		bool readahead) {
+	if (start >= end)
+		return;
+
+	struct prefetch_req *req = malloc (sizeof *req);
+	if (req == NULL)
+		return;
+	req->owner = owner;
+	req->start = start;
+	req->end = end;
+	req->readahead = readahead;
+
+	lock_acquire (&prefetch_lock);
+	if (prefetch_queued >= PREFETCH_QUEUE_MAX) {
+		lock_release (&prefetch_lock);
+		free (req);
+		return;
+	}
+	list_push_back (&prefetch_queue, &req->elem);
+	prefetch_queued++;
+	cond_signal (&prefetch_ready, &prefetch_lock);
+	lock_release (&prefetch_lock);
+}
+
+/* Claims queued pages one at a time, checking for cancellation between
+ * pages. */
+static void
+prefetch_worker (void *aux UNUSED) {
+	for (;;) {
+		lock_acquire (&prefetch_lock);
+		while (list_empty (&prefetch_queue))
+			cond_wait (&prefetch_ready, &prefetch_lock);
+		struct prefetch_req *req = list_entry (list_pop_front (&prefetch_queue),
+				struct prefetch_req, elem);
+		prefetch_queued--;
+		prefetch_owner = req->owner;
+		lock_release (&prefetch_lock);
+
+		for (void *va = req->start; va < req->end; va += PGSIZE) {
+			lock_acquire (&prefetch_lock);
+			bool cancel = prefetch_cancel;
+			lock_release (&prefetch_lock);
+			if (cancel)
+				break;
+
+			if (vm_prefetch_page (&req->owner->spt, va)) {
+				if (req->readahead)
+					readahead_cnt++;
+				else
+					prefetch_cnt++;
+			}
+		}
+
+		lock_acquire (&prefetch_lock);
+		prefetch_owner = NULL;
+		prefetch_cancel = false;
+		cond_broadcast (&prefetch_idle, &prefetch_lock);
+		lock_release (&prefetch_lock);
+		free (req);
+	}
+}
+
+/* Drops OWNER's queued prefetch requests and waits until the prefetch
+ * thread is no longer working on one.  Called before OWNER's pages are
+ * destroyed. */
+void
+advise_cancel (struct thread *owner) {
+	lock_acquire (&prefetch_lock);
+	struct list_elem *e = list_begin (&prefetch_queue);
+	while (e != list_end (&prefetch_queue)) {
+		struct prefetch_req *req = list_entry (e, struct prefetch_req, elem);
+		if (req->owner == owner) {
+			e = list_remove (e);
+			prefetch_queued--;
+			free (req);
+		} else
+			e = list_next (e);
+	}
+	while (prefetch_owner == owner) {
+		prefetch_cancel = true;
+		cond_wait (&prefetch_idle, &prefetch_lock);
+	}
+	lock_release (&prefetch_lock);
+}
+
+/* Prefetches [ADDR, ADDR + LENGTH) of the current process in the
+ * background, for mmap(MAP_POPULATE). */
+void
+advise_prefetch (void *addr, size_t length) {
+	prefetch_enqueue (thread_current (), pg_round_down (addr),
+			pg_round_up (addr + length), false);
+}
+
+/* Called after a fault on PAGE has been resolved in its owner's
+ * context.  Reads ahead and reclaims behind SEQUENTIAL pages. */
+void
+advise_fault (struct page *page) {
+	if (page->advice != MADV_SEQUENTIAL)
+		return;
+
+	struct supplemental_page_table *spt = &page->owner->spt;
+	void *end = page->va + PGSIZE;
+	for (int i = 0; i < RA_PAGES; i++, end += PGSIZE) {
+		struct page *next = spt_find_page (spt, end);
+		if (next == NULL || next->advice != MADV_SEQUENTIAL)
+			break;
+	}
+	prefetch_enqueue (page->owner, page->va + PGSIZE, end, true);
+
+	// 이미 지나간 페이지는 다시 쓰이지 않을 가능성이 높으므로 clock이 먼저 가져가게 함
+	void *behind = page->va - RA_PAGES * PGSIZE;
+	if (behind < page->va) {
+		struct page *prev = spt_find_page (spt, behind);
+		if (prev != NULL && prev->advice == MADV_SEQUENTIAL)
+			pml4_set_accessed (page->owner->pml4, behind, false);
+	}
+}
+
+/* Gives PAGE's memory back now.  A file-backed page is unmapped from the
+ * page cache, which keeps its contents for the next access; an anonymous
+ * page goes back to its untouched state and reads as zeros, as a private
+ * anonymous mapping does.  Read-only pages (program text) are left alone. */
+static void
+dontneed_page (struct supplemental_page_table *spt, struct page *page) {
+	lock_acquire (&spt->lock);
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_PAGE_CACHE:
+			// 매핑만 끊음. 내용은 page cache에 남아 있어 다음 fault에 바로 다시 매핑됨
+			if (page->frame != NULL) {
+				swap_out (page);
+				dontneed_cnt++;
+			}
+			break;
+		case VM_ANON:
+			if (page->writable) {
+				struct thread *owner = page->owner;
+				uint8_t advice = page->advice;
+				struct hash_elem elem = page->hash_elem;
+
+				if (page->frame != NULL)
+					dontneed_cnt++;
+				// frame과 swap slot을 반납하고 initializer 없는 uninit 페이지로 되돌림
+				destroy (page);
+				uninit_new (page, page->va, NULL, VM_ANON, NULL, anon_initializer);
+				page->writable = true;
+				page->owner = owner;
+				page->advice = advice;
+				page->hash_elem = elem;     // uninit_new가 덮어쓴 hash 연결 복구
+			}
+			break;
+		default:
+			break;
+	}
+	lock_release (&spt->lock);
+}
+
+/* Applies ADVICE to [ADDR, ADDR + LENGTH) of the current process.
+ * Returns false if ADVICE is unknown or part of the range is unmapped. */
+bool
+do_madvise (void *addr, size_t length, int advice) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	void *start = pg_round_down (addr);
+	void *end = pg_round_up (addr + length);
+
+	if (advice < MADV_NORMAL || advice > MADV_DONTNEED)
+		return false;
+	for (void *va = start; va < end; va += PGSIZE)
+		if (spt_find_page (spt, va) == NULL)
+			return false;
+
+	switch (advice) {
+		case MADV_WILLNEED:
+			prefetch_enqueue (thread_current (), start, end, false);
+			break;
+		case MADV_DONTNEED:
+			for (void *va = start; va < end; va += PGSIZE)
+				dontneed_page (spt, spt_find_page (spt, va));
+			break;
+		default:
+			for (void *va = start; va < end; va += PGSIZE)
+				spt_find_page (spt, va)->advice = advice;
+			break;
+	}
+	return true;
+}
+
+/* Prints prefetch statistics. */
+void
+advise_print_stats (void) {
+	printf ("Advice: %lld pages prefetched, %lld read ahead, %lld dropped\n",
+			prefetch_cnt, readahead_cnt, dontneed_cnt);
+}
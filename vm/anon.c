@@ -1,8 +1,14 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "vm/vm.h"
 #include "devices/disk.h"
 #include "bitmap.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "vm/ksm.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -18,16 +24,171 @@ static const struct page_operations anon_ops = {
 	.type = VM_ANON,
 };
 
-// for anon_init
-struct bitmap *swap_table;
+/* 최대 swap 영역 수 (IDE 디스크 수) */
+#define SWAP_AREA_MAX 4
+/* 같은 priority의 영역들을 돌아가며 쓰는 단위 (페이지) */
+#define SWAP_CLUSTER 8
+/* swap_index의 하위 비트는 영역 안의 slot 번호, 상위 비트는 영역 번호 */
+#define SWAP_SLOT_BITS 24
+#define SWAP_SLOT_MASK ((1 << SWAP_SLOT_BITS) - 1)
+
+/* A swap area: a range of sectors on one disk. */
+struct swap_area {
+	struct disk *disk;
+	int chan_no, dev_no;            /* Disk is hdCHAN_NO:DEV_NO. */
+	disk_sector_t start;            /* First sector. */
+	int prio;                       /* Higher is used first. */
+	struct bitmap *used;            /* Slots in use. */
+	size_t next;                    /* Where to look for a free slot. */
+	long long read_cnt;             /* Pages read. */
+	long long write_cnt;            /* Pages written. */
+};
+
+/* -swap 옵션. 없으면 hd1:1 전체를 swap으로 씀 */
+const char *swap_spec;
+
+// 사용 중인 swap 영역. priority가 높은 것부터 정렬되어 있음
+static struct swap_area swap_areas[SWAP_AREA_MAX];
+static size_t swap_area_cnt;
+// slot 할당과 반납을 보호
+static struct lock swap_lock;
+// 지금 cluster를 채우고 있는 영역과 그 cluster에 남은 slot 수
+static size_t stripe_cur;
+static size_t stripe_left;
+
 const size_t SECTORS_PER_PAGE = PGSIZE / DISK_SECTOR_SIZE;
 
+// swap cache 통계: 실제로 쓴 페이지 수 / clean 해서 쓰기를 생략한 페이지 수
+static long long swap_write_cnt;
+static long long swap_clean_skip_cnt;
+
+/* Adds hdCHAN_NO:DEV_NO from sector START on as a swap area with PRIO. */
+static void
+swap_add_area (int chan_no, int dev_no, disk_sector_t start, int prio) {
+	struct disk *disk = chan_no >= 0 && (dev_no == 0 || dev_no == 1)
+		? disk_get (chan_no, dev_no) : NULL;
+	if (disk == NULL || start >= disk_size (disk)
+			|| swap_area_cnt == SWAP_AREA_MAX) {
+		printf ("swap: hd%d:%d cannot be used\n", chan_no, dev_no);
+		return;
+	}
+	size_t slot_cnt = (disk_size (disk) - start) / SECTORS_PER_PAGE;
+
+	// priority 순서를 유지하며 삽입. 같은 priority는 주어진 순서대로
+	size_t i = swap_area_cnt++;
+	for (; i > 0 && swap_areas[i - 1].prio < prio; i--)
+		swap_areas[i] = swap_areas[i - 1];
+	struct swap_area *a = &swap_areas[i];
+	a->disk = disk;
+	a->chan_no = chan_no;
+	a->dev_no = dev_no;
+	a->start = start;
+	a->prio = prio;
+	a->used = bitmap_create (slot_cnt);
+	a->next = 0;
+	a->read_cnt = a->write_cnt = 0;
+	if (a->used == NULL)
+		PANIC ("swap: out of memory for hd%d:%d slot bitmap", chan_no, dev_no);
+}
+
+/* Parses SPEC, a comma-separated list of CHAN:DEV[:PRIO[:SECTOR]]
+ * entries, and adds each as a swap area. */
+static void
+swap_parse_spec (const char *spec) {
+	char buf[64];
+	char *entry, *save_ptr;
+
+	strlcpy (buf, spec, sizeof buf);
+	for (entry = strtok_r (buf, ",", &save_ptr); entry != NULL;
+			entry = strtok_r (NULL, ",", &save_ptr)) {
+		char *field, *field_ptr;
+		int v[4] = { -1, -1, 0, 0 };
+		int n = 0;
+
+		for (field = strtok_r (entry, ":", &field_ptr); field != NULL && n < 4;
+				field = strtok_r (NULL, ":", &field_ptr))
+			v[n++] = atoi (field);
+		if (n < 2)
+			PANIC ("swap: bad area `%s' (use CHAN:DEV[:PRIO[:SECTOR]])", entry);
+		swap_add_area (v[0], v[1], v[3], v[2]);
+	}
+}
+
 /* Initialize the data for anonymous pages */
 void vm_anon_init (void) {
 	/* TODO: Set up the swap_disk. */
-	swap_disk = disk_get(1, 1);
-    size_t swap_size = disk_size(swap_disk) / SECTORS_PER_PAGE;
-    swap_table = bitmap_create(swap_size);
+	lock_init (&swap_lock);
+	if (swap_spec != NULL)
+		swap_parse_spec (swap_spec);
+	else
+		swap_add_area (1, 1, 0, 0);
+	swap_disk = swap_area_cnt > 0 ? swap_areas[0].disk : NULL;
+}
+
+/* Takes a free slot of A.  Caller holds swap_lock. */
+static size_t
+swap_area_alloc (struct swap_area *a) {
+	// 마지막으로 준 slot 바로 다음부터 찾아 한 cluster가 디스크에서 이어지게 함
+	size_t slot = bitmap_scan_and_flip (a->used, a->next, 1, false);
+	if (slot == BITMAP_ERROR && a->next != 0)
+		slot = bitmap_scan_and_flip (a->used, 0, 1, false);
+	if (slot != BITMAP_ERROR)
+		a->next = slot + 1;
+	return slot;
+}
+
+/* Allocates a swap slot and returns its swap_index, or SWAP_SLOT_NONE if
+ * every area is full.  Areas are used in order of priority; areas of
+ * equal priority take SWAP_CLUSTER slots in turn, so consecutive
+ * evictions are spread over their disks. */
+static int
+swap_alloc (void) {
+	int index = SWAP_SLOT_NONE;
+
+	lock_acquire (&swap_lock);
+	for (size_t g = 0, h; g < swap_area_cnt && index == SWAP_SLOT_NONE; g = h) {
+		// [g, h): priority가 같은 영역들
+		for (h = g + 1; h < swap_area_cnt && swap_areas[h].prio == swap_areas[g].prio; h++)
+			continue;
+		if (stripe_cur < g || stripe_cur >= h) {
+			stripe_cur = g;
+			stripe_left = SWAP_CLUSTER;
+		}
+		for (size_t tried = 0; tried <= h - g; tried++) {
+			if (stripe_left == 0) {
+				stripe_cur = stripe_cur + 1 < h ? stripe_cur + 1 : g;
+				stripe_left = SWAP_CLUSTER;
+			}
+			size_t slot = swap_area_alloc (&swap_areas[stripe_cur]);
+			if (slot != BITMAP_ERROR) {
+				stripe_left--;
+				index = (int) (stripe_cur << SWAP_SLOT_BITS | slot);
+				break;
+			}
+			// 가득 찬 영역은 건너뜀
+			stripe_left = 0;
+		}
+	}
+	lock_release (&swap_lock);
+	return index;
+}
+
+/* Returns the area INDEX is in and stores its slot in *SLOT. */
+static struct swap_area *
+swap_locate (int index, size_t *slot) {
+	*slot = index & SWAP_SLOT_MASK;
+	return &swap_areas[index >> SWAP_SLOT_BITS];
+}
+
+/* Frees the swap slot INDEX. */
+static void
+swap_free (int index) {
+	size_t slot;
+	struct swap_area *a = swap_locate (index, &slot);
+
+	lock_acquire (&swap_lock);
+	bitmap_reset (a->used, slot);
+	lock_release (&swap_lock);
 }
 
 /* Initialize the file mapping */
@@ -37,49 +198,128 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
+	anon_page->swap_index = SWAP_SLOT_NONE;
+	return true;
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* Swap in the page by read contents from the swap disk.
+ * swap slot은 바로 반납하지 않고 페이지에 계속 붙여둔다 (swap cache).
+ * 다시 쫓겨날 때까지 수정되지 않았다면 디스크에 있는 내용이 그대로 유효하므로
+ * 쓰기를 생략할 수 있음. 수정되면 anon_drop_stale_slot()이 반납. */
 static bool anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
 
 	int page_no = anon_page->swap_index;
+	size_t slot;
 
-    if (bitmap_test(swap_table, page_no) == false) {
+    if (page_no == SWAP_SLOT_NONE)
+        return false;
+    struct swap_area *a = swap_locate(page_no, &slot);
+    if (bitmap_test(a->used, slot) == false)
         return false;
-    }
 
     for (int i = 0; i < SECTORS_PER_PAGE; ++i) {
-        disk_read(swap_disk, page_no * SECTORS_PER_PAGE + i, kva + DISK_SECTOR_SIZE * i);
+        disk_read(a->disk, a->start + slot * SECTORS_PER_PAGE + i, kva + DISK_SECTOR_SIZE * i);
     }
+    a->read_cnt++;
 
-    bitmap_set(swap_table, page_no, false);
-    
     return true;
 }
-/* Swap out the page by writing contents to the swap disk. */
+
+/* Swap out the page by writing contents to the swap disk.
+ * 이미 slot을 가지고 있고 swap in 이후 dirty bit가 서지 않았다면 쓰기 없이 매핑만 해제.
+ * clock이 아직 보지 못한 사이에 dirty가 됐다면 가지고 있던 slot에 그대로 덮어쓴다.
+ * pageout daemon이 다른 프로세스의 페이지를 쫓아낼 수 있으므로 쓰기 전에 매핑부터 해제해서
+ * 쓰는 도중 주인이 내용을 바꾸지 못하게 함 (dirty bit는 PTE에 그대로 남아 있음). */
 static bool anon_swap_out (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+	uint64_t *pml4 = page->owner->pml4;
+
+	int page_no = anon_page->swap_index;
+	bool has_slot = page_no != SWAP_SLOT_NONE;
 
-	int page_no = bitmap_scan(swap_table, 0, 1, false);
+	if (!has_slot) {
+		page_no = swap_alloc();
 
-    if (page_no == BITMAP_ERROR) {
-        return false;
-    }
+		if (page_no == SWAP_SLOT_NONE) {
+			return false;
+		}
+		anon_page->swap_index = page_no;
+	}
 
+	pml4_clear_page(pml4, page->va);
+
+	if (has_slot && !pml4_is_dirty(pml4, page->va)) {
+		swap_clean_skip_cnt++;
+		return true;
+	}
+
+    size_t slot;
+    struct swap_area *a = swap_locate(page_no, &slot);
     for (int i = 0; i < SECTORS_PER_PAGE; ++i) {
-        disk_write(swap_disk, page_no * SECTORS_PER_PAGE + i, page->va + DISK_SECTOR_SIZE * i);
+        disk_write(a->disk, a->start + slot * SECTORS_PER_PAGE + i, page->frame->kva + DISK_SECTOR_SIZE * i);
     }
+    a->write_cnt++;
+    swap_write_cnt++;
 
-    bitmap_set(swap_table, page_no, true);
-    pml4_clear_page(thread_current()->pml4, page->va);
+    return true;
+}
 
-    anon_page->swap_index = page_no;
+/* Frees the swap slot of PAGE, a resident anonymous page, if PAGE was
+ * written since it was swapped in.  The slot's copy is stale then, and
+ * holding on to it would leave swap full of slots no eviction can use;
+ * the page gets a new slot when it is swapped out again.  Only clean
+ * pages keep their slots, to be evicted without a write.
+ * Called by the eviction clock with frame_lock held and PAGE's frame not
+ * pinned, which keeps PAGE from being swapped out or destroyed. */
+void
+anon_drop_stale_slot (struct page *page) {
+	struct anon_page *anon_page = &page->anon;
+	uint64_t *pml4 = page->owner->pml4;
 
-    return true;
+	if (anon_page->swap_index != SWAP_SLOT_NONE && pml4 != NULL
+			&& pml4_is_dirty (pml4, page->va)) {
+		swap_free (anon_page->swap_index);
+		anon_page->swap_index = SWAP_SLOT_NONE;
+	}
 }
-/* Destroy the anonymous page. PAGE will be freed by the caller. */
+
+/* Destroy the anonymous page. PAGE will be freed by the caller.
+ * 프로세스가 끝날 때 swap slot을 반납하는 곳. */
 static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
-}
\ No newline at end of file
+
+	// ksm이 후보로 보고 이 frame을 잡지 않도록 먼저 후보 테이블에서 뺌
+	ksm_forget(page);
+	vm_free_frame(page);
+	// ksm이 이미 검사 중이었다면 vm_free_frame이 끝나기를 기다렸고,
+	// 그 사이 다시 후보로 넣었을 수 있으므로 한 번 더 뺌
+	ksm_forget(page);
+
+	if (anon_page->swap_index != SWAP_SLOT_NONE) {
+		swap_free(anon_page->swap_index);
+		anon_page->swap_index = SWAP_SLOT_NONE;
+	}
+}
+
+/* Prints swap statistics. */
+void
+anon_print_stats (void) {
+	printf ("Swap: %lld pages written, %lld clean evictions skipped\n",
+			swap_write_cnt, swap_clean_skip_cnt);
+	swap_status ();
+}
+
+/* Prints the state of every swap area. */
+void
+swap_status (void) {
+	for (size_t i = 0; i < swap_area_cnt; i++) {
+		struct swap_area *a = &swap_areas[i];
+		printf ("Swap hd%d:%d: priority %d, %zu of %zu slots used, "
+				"%lld pages read, %lld written\n",
+				a->chan_no, a->dev_no, a->prio,
+				bitmap_count (a->used, 0, bitmap_size (a->used), true),
+				bitmap_size (a->used), a->read_cnt, a->write_cnt);
+	}
+}
@@ -1,13 +1,26 @@
-/* file.c: Implementation of memory backed file object (mmaped object). */
-
+/* file.c: Implementation of memory backed file object (mmaped object).
+ *
+ * A file mapping is made of VM_PAGE_CACHE pages, which map the file's
+ * pages in the page cache (filesys/page_cache.c) instead of private
+ * copies, so read(), write() and every mapping of a file share one copy
+ * of each page.  The cache writes dirty pages back in the background;
+ * msync() and munmap() write a mapping's pages right away. */
+
+#include <stdio.h>
+#include <string.h>
 #include "vm/vm.h"
 #include "userprog/process.h"
+#include "threads/malloc.h"
 #include "threads/mmu.h"
+#include "threads/thread.h"
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
 static void file_backed_destroy (struct page *page);
 
+// 통계: msync, munmap에서 쓴 페이지 수
+static long long writeback_sync_cnt;
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
 	.swap_in = file_backed_swap_in,
@@ -28,6 +41,7 @@ file_backed_initializer (struct page *page, enum vm_type type, void *kva) {
 	page->operations = &file_ops;
 
 	struct file_page *file_page = &page->file;
+	return true;
 }
 
 /* Swap in the page by read contents from the file. */
@@ -64,20 +78,82 @@ static bool file_backed_swap_out (struct page *page) {
         return false;
 
     struct container * aux = (struct container *) page->uninit.aux;
-    
+    // pageout daemon에서도 불리므로 현재 스레드가 아닌 주인의 pml4와 frame의 커널 주소를 사용
+    uint64_t *pml4 = page->owner->pml4;
+
+    // 쓰는 도중 주인이 수정하지 못하도록 매핑부터 해제 (dirty bit는 남아 있음)
+    pml4_clear_page(pml4, page->va);
+
     // 사용 되었던 페이지(dirty page)인지 체크
-    if(pml4_is_dirty(thread_current()->pml4, page->va)){
-        file_write_at(aux->file, page->va, aux->page_read_bytes, aux->offset);
-        pml4_set_dirty (thread_current()->pml4, page->va, 0);
+    if(pml4_is_dirty(pml4, page->va)){
+        file_write_at(aux->file, page->frame->kva, aux->page_read_bytes, aux->offset);
+        pml4_set_dirty (pml4, page->va, 0);
     }
-
-    pml4_clear_page(thread_current()->pml4, page->va);
+    return true;
 }
 
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void
 file_backed_destroy (struct page *page) {
 	struct file_page *file_page UNUSED = &page->file;
+
+	// munmap, exit에서 미리 flush 하므로 보통은 clean. 남은 것만 씀
+	struct frame *frame = page->frame;
+	uint64_t *pml4 = page->owner->pml4;
+	if (frame != NULL && pml4 != NULL && pml4_is_dirty(pml4, page->va)) {
+		struct container *aux = (struct container *) page->uninit.aux;
+		file_write_at(aux->file, frame->kva, aux->page_read_bytes, aux->offset);
+		writeback_sync_cnt++;
+	}
+	vm_free_frame(page);
+}
+
+/* Returns the file that PAGE, a page of a file mapping, maps. */
+static struct file *
+mapping_file (struct page *page) {
+	if (VM_TYPE (page->operations->type) == VM_UNINIT)
+		return ((struct container *) page->uninit.aux)->file;
+	return page->page_cache.file;
+}
+
+/* Writes back the dirty pages of the current process's file mappings
+ * in [ADDR, ADDR + LENGTH).  Returns false if part of the range is not
+ * file-mapped. */
+bool
+do_msync (void *addr, size_t length) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	void *start = pg_round_down (addr);
+	void *end = pg_round_up (addr + length);
+
+	for (void *va = start; va < end; va += PGSIZE) {
+		struct page *page = spt_find_page (spt, va);
+		if (page == NULL || page_get_type (page) != VM_PAGE_CACHE)
+			return false;
+	}
+	for (void *va = start; va < end; va += PGSIZE)
+		writeback_sync_cnt += page_cache_sync (spt_find_page (spt, va));
+	return true;
+}
+
+/* Detaches the current process's file mappings from the page cache,
+ * leaving their dirty data there.  Called on exit while the page
+ * tables, which hold the dirty bits, are still intact. */
+void
+file_backed_unmap_all (void) {
+	struct hash_iterator i;
+
+	hash_first (&i, &thread_current ()->spt.pages);
+	while (hash_next (&i)) {
+		struct page *page = hash_entry (hash_cur (&i), struct page, hash_elem);
+		if (VM_TYPE (page->operations->type) == VM_PAGE_CACHE)
+			swap_out (page);
+	}
+}
+
+/* Prints writeback statistics. */
+void
+file_print_stats (void) {
+	printf ("Writeback: %lld pages on msync/munmap\n", writeback_sync_cnt);
 }
 
 /* Do the mmap */
@@ -97,7 +173,7 @@ void *do_mmap (void *addr, size_t length, int writable, struct file *file, off_t
         container->offset = offset;
         container->page_read_bytes = page_read_bytes;
 
-		if (!vm_alloc_page_with_initializer (VM_FILE, addr, writable, lazy_load_segment, container)) {
+		if (!vm_alloc_page_with_initializer (VM_PAGE_CACHE, addr, writable, NULL, container)) {
 			return NULL;
         }
 		read_bytes -= page_read_bytes;
@@ -110,21 +186,33 @@ void *do_mmap (void *addr, size_t length, int writable, struct file *file, off_t
 
 /* Do the munmap */
 void do_munmap (void *addr) {   // 매핑된 파일의 페이지 제거
-	while (true) {
-        struct page* page = spt_find_page(&thread_current()->spt, addr);
-        
-        if (page == NULL)
-            break;
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct page *first = spt_find_page(spt, addr);
 
-        struct container * aux = (struct container *) page->uninit.aux;
-        
-        // dirty(사용되었던) bit 체크
-        if(pml4_is_dirty(thread_current()->pml4, page->va)) {
-            file_write_at(aux->file, addr, aux->page_read_bytes, aux->offset);
-            pml4_set_dirty (thread_current()->pml4, page->va, 0);
-        }
+	if (first == NULL || page_get_type(first) != VM_PAGE_CACHE)
+		return;
 
-        pml4_clear_page(thread_current()->pml4, page->va);
-        addr += PGSIZE;
-    }
+	// mmap마다 file_reopen 하므로 같은 file을 가진 연속된 페이지가 하나의 매핑
+	struct file *mfile = mapping_file(first);
+	void *end = addr;
+	while (true) {
+		struct page *page = spt_find_page(spt, end);
+		if (page == NULL || page_get_type(page) != VM_PAGE_CACHE
+				|| mapping_file(page) != mfile)
+			break;
+		end += PGSIZE;
+	}
+
+	// 남은 dirty 페이지를 offset 순으로 한 번에 기록한 뒤 페이지 제거
+	do_msync(addr, end - addr);
+	// prefetch worker가 지워지는 페이지를 claim 하지 않도록 spt lock을 잡고 제거
+	lock_acquire(&spt->lock);
+	// 매핑은 한 번의 walk로 지우고 TLB도 모아서 비움
+	vm_clear_range(thread_current()->pml4, addr, end);
+	for (void *va = addr; va < end; va += PGSIZE) {
+		struct page *page = spt_find_page(spt, va);
+		hash_delete(&spt->pages, &page->hash_elem);
+		vm_dealloc_page(page);
+	}
+	lock_release(&spt->lock);
 }
@@ -0,0 +1,259 @@
+/* ksm.c: Same-page merging for anonymous memory.
+ *
+ * Forked processes often hold many anonymous pages with the same contents,
+ * such as zeroed buffers or copies of a lookup table.  Every KSM_INTERVAL
+ * ticks the ksm thread looks at the next ksm_pages_per_pass frames of the
+ * frame table.  Each resident anonymous page is unmapped while it is
+ * checksummed and compared, so its owner cannot change it meanwhile:
+ *
+ *   - a page of zeros maps the zero page;
+ *   - a page equal to a merged frame maps that frame;
+ *   - a page equal to a candidate seen earlier with the same checksum turns
+ *     the candidate's frame into a new merged frame, and both map it;
+ *   - any other page is mapped again and becomes the candidate for its
+ *     checksum.
+ *
+ * Merged frames are shared frames (vm/shared.c) mapped read-only, so the
+ * first write to one goes through the write-protect fault path and gets a
+ * private copy back.  They leave the frame table and cannot be evicted;
+ * vm/shared.c caps how many there are. */
+
+#include <stdio.h>
+#include <string.h>
+#include "vm/ksm.h"
+#include "vm/shared.h"
+#include "vm/vm.h"
+#include "devices/timer.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* 깨어나는 간격 (ticks) */
+#define KSM_INTERVAL (TIMER_FREQ / 10)
+/* 한 번에 살펴볼 수 있는 frame 수의 상한 */
+#define KSM_MAX_BATCH 256
+
+size_t ksm_pages_per_pass = 64;
+
+/* checksum -> 가장 최근에 본 그 checksum의 페이지 */
+static struct hash candidates;
+static struct lock ksm_lock;
+
+/* frame table 안에서 다음에 살펴볼 위치 */
+static struct frame cursor;
+static struct page *batch[KSM_MAX_BATCH];
+static size_t batch_cnt;
+static bool ksm_started;
+static int64_t ksm_start_ticks;
+
+// 통계: 살펴본 페이지 수 / 같은 내용의 frame으로 합친 페이지 수 / zero page로 합친 페이지 수
+static long long scan_cnt;
+static long long merge_cnt;
+static long long zero_merge_cnt;
+
+static void ksm_daemon (void *aux);
+
+static uint64_t
+candidate_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct page, ksm_elem)->ksm_checksum);
+}
+
+static bool
+candidate_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct page, ksm_elem)->ksm_checksum
+		< hash_entry (b, struct page, ksm_elem)->ksm_checksum;
+}
+
+/* Starts the ksm thread unless it is disabled by -ksm-pages=0. */
+void
+vm_ksm_init (void) {
+	hash_init (&candidates, candidate_hash, candidate_less, NULL);
+	lock_init (&ksm_lock);
+	if (ksm_pages_per_pass == 0)
+		return;
+	if (ksm_pages_per_pass > KSM_MAX_BATCH)
+		ksm_pages_per_pass = KSM_MAX_BATCH;
+
+	vm_add_frame_cursor (&cursor);
+	ksm_start_ticks = timer_ticks ();
+	ksm_started = thread_create ("ksm", PRI_DEFAULT, ksm_daemon, NULL)
+		!= TID_ERROR;
+}
+
+/* Removes PAGE from the candidate table.  Called when an anonymous page
+ * is destroyed, after its frame is gone. */
+void
+ksm_forget (struct page *page) {
+	lock_acquire (&ksm_lock);
+	if (page->ksm_candidate) {
+		hash_delete (&candidates, &page->ksm_elem);
+		page->ksm_candidate = false;
+	}
+	lock_release (&ksm_lock);
+}
+
+static bool
+is_anon_page (struct page *page, void *aux UNUSED) {
+	return VM_TYPE (page->operations->type) == VM_ANON;
+}
+
+static bool
+is_zero_page (const void *kva) {
+	const uint64_t *p = kva;
+	for (size_t i = 0; i < PGSIZE / sizeof *p; i++)
+		if (p[i] != 0)
+			return false;
+	return true;
+}
+
+/* Mapping state saved while a page is unmapped for comparison. */
+struct unmapped {
+	bool dirty;
+	bool accessed;
+};
+
+/* Unmaps PAGE so that its owner cannot write it while it is compared.
+ * An access by the owner waits on evict_lock, which the caller holds. */
+static struct unmapped
+unmap_page (struct page *page) {
+	uint64_t *pml4 = page->owner->pml4;
+	struct unmapped u = {
+		.dirty = pml4_is_dirty (pml4, page->va),
+		.accessed = pml4_is_accessed (pml4, page->va),
+	};
+	pml4_clear_page (pml4, page->va);
+	return u;
+}
+
+/* Maps PAGE's private frame again with the bits saved by unmap_page(). */
+static void
+remap_page (struct page *page, struct unmapped u) {
+	uint64_t *pml4 = page->owner->pml4;
+	pml4_set_page (pml4, page->va, page->frame->kva, page->writable);
+	pml4_set_dirty (pml4, page->va, u.dirty);
+	pml4_set_accessed (pml4, page->va, u.accessed);
+}
+
+/* Returns true if PAGE's frame is pinned as part of the current batch. */
+static bool
+in_batch (struct page *page) {
+	for (size_t i = 0; i < batch_cnt; i++)
+		if (batch[i] == page)
+			return true;
+	return false;
+}
+
+/* Looks for a candidate other than PAGE with CHECKSUM and the same
+ * contents as KVA.  If there is one, its frame becomes a merged frame.
+ * Returns true if a merged frame with CHECKSUM was created. */
+static bool
+merge_with_candidate (struct page *page, const void *kva, uint32_t checksum) {
+	struct page key;
+	struct page *cand = NULL;
+	bool ours = false;
+
+	key.ksm_checksum = checksum;
+	lock_acquire (&ksm_lock);
+	struct hash_elem *e = hash_find (&candidates, &key.ksm_elem);
+	if (e != NULL) {
+		cand = hash_entry (e, struct page, ksm_elem);
+		hash_delete (&candidates, e);
+		cand->ksm_candidate = false;
+		// 같은 batch의 후보는 이미 pin 되어 있음. 아니면 frame이 없거나 누가 쓰고 있으면 포기
+		ours = in_batch (cand);
+		if (cand == page || (!ours && !vm_try_pin_frame (cand)))
+			cand = NULL;
+	}
+	lock_release (&ksm_lock);
+	if (cand == NULL)
+		return false;
+
+	struct frame *frame = cand->frame;
+	struct unmapped u = unmap_page (cand);
+	if (memcmp (frame->kva, kva, PGSIZE) == 0
+			&& shared_ksm_insert (cand, frame->kva, checksum)) {
+		vm_detach_frame (frame);
+		return true;
+	}
+	remap_page (cand, u);
+	if (!ours)
+		vm_unpin_frame (frame);
+	return false;
+}
+
+/* Tries to merge PAGE, whose frame the caller has pinned. */
+static void
+ksm_scan_page (struct page *page) {
+	struct frame *frame = page->frame;
+	void *kva = frame->kva;
+
+	ksm_forget (page);
+	struct unmapped u = unmap_page (page);
+	scan_cnt++;
+
+	if (is_zero_page (kva)) {
+		if (shared_map_zero (page)) {
+			palloc_free_page (vm_detach_frame (frame));
+			zero_merge_cnt++;
+			return;
+		}
+		page->frame = frame;
+	}
+
+	uint32_t checksum = hash_bytes (kva, PGSIZE);
+	if (shared_ksm_merge (page, kva, checksum)
+			|| (merge_with_candidate (page, kva, checksum)
+				&& shared_ksm_merge (page, kva, checksum))) {
+		palloc_free_page (vm_detach_frame (frame));
+		merge_cnt++;
+		return;
+	}
+
+	// 합칠 상대가 없으면 다시 매핑하고 이 checksum의 후보로 남김
+	remap_page (page, u);
+	page->ksm_checksum = checksum;
+	lock_acquire (&ksm_lock);
+	struct hash_elem *old = hash_replace (&candidates, &page->ksm_elem);
+	if (old != NULL)
+		hash_entry (old, struct page, ksm_elem)->ksm_candidate = false;
+	page->ksm_candidate = true;
+	lock_release (&ksm_lock);
+}
+
+/* Scans the next slice of the frame table every KSM_INTERVAL ticks. */
+static void
+ksm_daemon (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (KSM_INTERVAL);
+
+		size_t cnt = vm_pin_frames_after (&cursor, is_anon_page, NULL,
+				batch, ksm_pages_per_pass);
+		batch_cnt = cnt;
+		for (size_t i = 0; i < cnt; i++)
+			ksm_scan_page (batch[i]);
+		batch_cnt = 0;
+
+		// 합쳐진 페이지의 frame은 이미 떼어냈으므로 남은 private frame만 unpin
+		size_t kept = 0;
+		for (size_t i = 0; i < cnt; i++)
+			if (!batch[i]->frame->shared)
+				batch[kept++] = batch[i];
+		vm_unpin_frames (batch, kept);
+	}
+}
+
+/* Prints merging statistics. */
+void
+ksm_print_stats (void) {
+	if (!ksm_started) {
+		printf ("KSM: off\n");
+		return;
+	}
+	int64_t elapsed = timer_elapsed (ksm_start_ticks);
+	printf ("KSM: %lld pages scanned (%lld pages/s), %lld merged, "
+			"%lld into the zero page\n", scan_cnt,
+			elapsed > 0 ? scan_cnt * TIMER_FREQ / elapsed : 0,
+			merge_cnt, zero_merge_cnt);
+}
@@ -0,0 +1,290 @@
+/* launch.c: Launch prefetch from recorded page-fault traces.
+ *
+ * Every exec of a program takes the same lazy_load_segment() faults in
+ * about the same order, each waiting for a disk read.  For the first
+ * LAUNCH_WINDOW ticks after exec, the file offsets of those faults are
+ * recorded in order.  When the window ends or the process exits, the
+ * trace becomes the executable's launch profile.  The next exec of the
+ * same executable hands the whole profile to the launch thread, which
+ * reads the pages into the page cache while the process starts, so its
+ * faults find them there.
+ *
+ * Profiles are kept in memory, LAUNCH_PROFILE_MAX of them, identified by
+ * the executable's inode and length and replaced least recently used
+ * first.  A profile is only a hint: a page that is not in it is read on
+ * demand as before.
+ *
+ * The cycles from exec to the process's first write to the console are
+ * measured for launches with a profile (warm) and without (cold). */
+
+#include <stdio.h>
+#include <string.h>
+#include "intrinsic.h"
+#include "vm/launch.h"
+#include "vm/vm.h"
+#include "devices/timer.h"
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "filesys/page_cache.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* exec 후 fault를 기록하는 시간 (500 ms) */
+#define LAUNCH_WINDOW (TIMER_FREQ / 2)
+/* 한 profile에 담는 최대 페이지 수 */
+#define LAUNCH_PAGES_MAX 256
+/* 기억하는 profile 수 */
+#define LAUNCH_PROFILE_MAX 32
+/* launch thread가 처리를 기다리는 최대 요청 수. 넘치면 새 요청은 버림 */
+#define LAUNCH_QUEUE_MAX 8
+
+/* Launch profile of one executable. */
+struct launch_profile {
+	disk_sector_t inumber;          /* Executable's inode. */
+	off_t length;                   /* Executable's length. */
+	int64_t used;                   /* Ticks at last exec, for LRU. */
+	size_t cnt;                     /* Number of offsets. */
+	off_t *offsets;                 /* Page offsets in fault order, NULL if unused. */
+};
+
+/* A process's launch, from exec to exit. */
+struct launch {
+	disk_sector_t inumber;
+	off_t length;
+	int64_t start_ticks;            /* Ticks at exec. */
+	uint64_t start_tsc;             /* rdtsc() at exec. */
+	bool warm;                      /* A profile was replayed. */
+	bool recording;                 /* Still recording faults. */
+	bool output_seen;               /* First output was measured. */
+	size_t cnt;
+	off_t offsets[LAUNCH_PAGES_MAX];
+};
+
+/* Pages of INODE for the launch thread to read. */
+struct launch_req {
+	struct inode *inode;            /* Reopened; closed when done. */
+	size_t cnt;
+	off_t *offsets;
+	struct list_elem elem;
+};
+
+/* Protects profiles, every thread's launch and the statistics. */
+static struct lock launch_lock;
+static struct launch_profile profiles[LAUNCH_PROFILE_MAX];
+
+static struct list launch_queue;
+static size_t launch_queued;
+static struct lock queue_lock;
+static struct condition queue_ready;
+
+// 통계: profile 없이 / profile로 시작한 exec 수, 각각 첫 출력까지 걸린 cycle 합과 측정 수,
+// 저장한 profile 수, launch thread가 디스크에서 읽은 페이지 수
+static long long cold_cnt, warm_cnt;
+static uint64_t cold_cycles, warm_cycles;
+static long long cold_output_cnt, warm_output_cnt;
+static long long profile_cnt;
+static long long prefetch_cnt;
+
+static void launch_worker (void *aux);
+
+/* Initializes the profile table and starts the launch thread. */
+void
+vm_launch_init (void) {
+	lock_init (&launch_lock);
+	list_init (&launch_queue);
+	lock_init (&queue_lock);
+	cond_init (&queue_ready);
+	thread_create ("launch", PRI_DEFAULT, launch_worker, NULL);
+}
+
+/* Returns the profile for INUMBER and LENGTH, or NULL.  Caller holds
+ * launch_lock. */
+static struct launch_profile *
+profile_find (disk_sector_t inumber, off_t length) {
+	for (int i = 0; i < LAUNCH_PROFILE_MAX; i++)
+		if (profiles[i].offsets != NULL && profiles[i].inumber == inumber
+				&& profiles[i].length == length)
+			return &profiles[i];
+	return NULL;
+}
+
+/* Stores L's trace as the profile of its executable and stops recording.
+ * Caller holds launch_lock. */
+static void
+profile_save (struct launch *l) {
+	l->recording = false;
+	if (l->cnt == 0 || profile_find (l->inumber, l->length) != NULL)
+		return;
+
+	off_t *offsets = malloc (l->cnt * sizeof *offsets);
+	if (offsets == NULL)
+		return;
+	memcpy (offsets, l->offsets, l->cnt * sizeof *offsets);
+
+	// 빈 자리가 없으면 가장 오래 쓰지 않은 profile을 버림
+	struct launch_profile *p = &profiles[0];
+	for (int i = 1; i < LAUNCH_PROFILE_MAX && p->offsets != NULL; i++)
+		if (profiles[i].offsets == NULL || profiles[i].used < p->used)
+			p = &profiles[i];
+	free (p->offsets);
+
+	p->inumber = l->inumber;
+	p->length = l->length;
+	p->used = timer_ticks ();
+	p->cnt = l->cnt;
+	p->offsets = offsets;
+	profile_cnt++;
+}
+
+/* Queues P's pages of INODE for the launch thread.  Caller holds
+ * launch_lock. */
+static bool
+launch_enqueue (struct inode *inode, struct launch_profile *p) {
+	struct launch_req *req = malloc (sizeof *req);
+	off_t *offsets = malloc (p->cnt * sizeof *offsets);
+	if (req == NULL || offsets == NULL) {
+		free (req);
+		free (offsets);
+		return false;
+	}
+	memcpy (offsets, p->offsets, p->cnt * sizeof *offsets);
+	req->cnt = p->cnt;
+	req->offsets = offsets;
+
+	lock_acquire (&queue_lock);
+	if (launch_queued >= LAUNCH_QUEUE_MAX) {
+		lock_release (&queue_lock);
+		free (offsets);
+		free (req);
+		return false;
+	}
+	req->inode = inode_reopen (inode);
+	list_push_back (&launch_queue, &req->elem);
+	launch_queued++;
+	cond_signal (&queue_ready, &queue_lock);
+	lock_release (&queue_lock);
+	return true;
+}
+
+/* Reads queued pages into the page cache. */
+static void
+launch_worker (void *aux UNUSED) {
+	for (;;) {
+		lock_acquire (&queue_lock);
+		while (list_empty (&launch_queue))
+			cond_wait (&queue_ready, &queue_lock);
+		struct launch_req *req = list_entry (list_pop_front (&launch_queue),
+				struct launch_req, elem);
+		launch_queued--;
+		lock_release (&queue_lock);
+
+		for (size_t i = 0; i < req->cnt; i++)
+			if (page_cache_prefetch (req->inode, req->offsets[i]))
+				prefetch_cnt++;
+
+		inode_close (req->inode);
+		free (req->offsets);
+		free (req);
+	}
+}
+
+/* Starts the current process's launch of FILE, its executable.  Replays
+ * FILE's profile if there is one and records one otherwise. */
+void
+launch_start (struct file *file) {
+	struct thread *t = thread_current ();
+	struct inode *inode = file_get_inode (file);
+
+	struct launch *l = malloc (sizeof *l);
+	if (l == NULL)
+		return;
+	l->inumber = inode_get_inumber (inode);
+	l->length = inode_length (inode);
+	l->start_ticks = timer_ticks ();
+	l->start_tsc = rdtsc ();
+	l->output_seen = false;
+	l->cnt = 0;
+
+	lock_acquire (&launch_lock);
+	struct launch_profile *p = profile_find (l->inumber, l->length);
+	if (p != NULL) {
+		p->used = l->start_ticks;
+		l->warm = launch_enqueue (inode, p);
+	} else
+		l->warm = false;
+	l->recording = p == NULL;
+	if (l->warm)
+		warm_cnt++;
+	else
+		cold_cnt++;
+	t->launch = l;
+	lock_release (&launch_lock);
+}
+
+/* Records a fault on PAGE of its owner's executable, at OFFSET.  Called
+ * from lazy_load_segment(), possibly by the prefetch thread on the
+ * owner's behalf. */
+void
+launch_record (struct page *page, off_t offset) {
+	lock_acquire (&launch_lock);
+	struct launch *l = page->owner->launch;
+	if (l != NULL && l->recording) {
+		if (timer_elapsed (l->start_ticks) >= LAUNCH_WINDOW)
+			profile_save (l);
+		else {
+			bool seen = false;
+			for (size_t i = 0; i < l->cnt && !seen; i++)
+				seen = l->offsets[i] == offset;
+			if (!seen)
+				l->offsets[l->cnt++] = offset;
+			if (l->cnt == LAUNCH_PAGES_MAX)
+				profile_save (l);
+		}
+	}
+	lock_release (&launch_lock);
+}
+
+/* Called when the current process writes to the console.  Measures the
+ * time from exec to the first such write. */
+void
+launch_first_output (void) {
+	struct launch *l = thread_current ()->launch;
+	if (l == NULL || l->output_seen)
+		return;
+
+	uint64_t cycles = rdtsc () - l->start_tsc;
+	lock_acquire (&launch_lock);
+	l->output_seen = true;
+	if (l->warm) {
+		warm_cycles += cycles;
+		warm_output_cnt++;
+	} else {
+		cold_cycles += cycles;
+		cold_output_cnt++;
+	}
+	lock_release (&launch_lock);
+}
+
+/* Ends T's launch, saving the trace recorded so far as a profile. */
+void
+launch_finish (struct thread *t) {
+	lock_acquire (&launch_lock);
+	struct launch *l = t->launch;
+	t->launch = NULL;
+	if (l != NULL && l->recording)
+		profile_save (l);
+	lock_release (&launch_lock);
+	free (l);
+}
+
+/* Prints launch statistics. */
+void
+launch_print_stats (void) {
+	printf ("Launch: %lld cold, %lld warm, %lld profiles saved, "
+			"%lld pages prefetched\n",
+			cold_cnt, warm_cnt, profile_cnt, prefetch_cnt);
+	printf ("Launch: %llu cycles to first output cold, %llu warm (average)\n",
+			cold_output_cnt ? (unsigned long long) (cold_cycles / cold_output_cnt) : 0,
+			warm_output_cnt ? (unsigned long long) (warm_cycles / warm_output_cnt) : 0);
+}
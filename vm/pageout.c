@@ -0,0 +1,112 @@
+/* pageout.c: Background page reclaim.
+ *
+ * Without help, vm_get_frame() evicts a frame only when the user pool is
+ * already empty, so the clock scan and the swap write land inside the
+ * faulting thread's page fault.  The pageout daemon keeps a reserve of free
+ * frames instead: it wakes up when the number of free user frames drops
+ * below the low watermark and evicts pages until the high watermark is
+ * reached.  Most faults then find a frame in palloc right away. */
+
+#include <stdio.h>
+#include "vm/pageout.h"
+#include "vm/vm.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Watermarks in pages. */
+size_t pageout_low_wm = 32;
+size_t pageout_high_wm = 64;
+
+static struct semaphore pageout_sema;
+static bool pageout_pending;            /* sema_up 했지만 아직 회수가 끝나지 않음 */
+static bool pageout_started;
+
+// 통계: daemon이 회수한 frame 수 / fault 처리 중에 직접 회수한 frame 수
+static long long daemon_reclaim_cnt;
+static long long direct_reclaim_cnt;
+
+/* Page fault latency histogram.  Bucket i counts faults that took
+ * [2^i, 2^(i+1)) TSC cycles. */
+#define FAULT_HIST_BUCKETS 40
+static long long fault_hist[FAULT_HIST_BUCKETS];
+static long long fault_cnt;
+
+static void pageout_daemon (void *aux);
+
+/* Starts the pageout daemon unless it is disabled by a zero low
+ * watermark. */
+void
+pageout_init (void) {
+	sema_init (&pageout_sema, 0);
+	if (pageout_low_wm == 0)
+		return;
+	if (pageout_high_wm < pageout_low_wm)
+		pageout_high_wm = pageout_low_wm;
+	pageout_started = thread_create ("pageout", PRI_DEFAULT,
+			pageout_daemon, NULL) != TID_ERROR;
+}
+
+/* Wakes the daemon if free user frames are below the low watermark.
+ * Called after every frame allocation. */
+void
+pageout_wake (void) {
+	if (!pageout_started || pageout_pending
+			|| palloc_user_free_cnt () >= pageout_low_wm)
+		return;
+	pageout_pending = true;
+	sema_up (&pageout_sema);
+}
+
+/* Counts a frame that a faulting thread had to evict by itself. */
+void
+pageout_count_direct (void) {
+	direct_reclaim_cnt++;
+}
+
+/* Adds a page fault that took CYCLES to the latency histogram. */
+void
+pageout_record_fault (uint64_t cycles) {
+	int bucket = 0;
+	while (cycles > 1 && bucket < FAULT_HIST_BUCKETS - 1) {
+		cycles >>= 1;
+		bucket++;
+	}
+	fault_hist[bucket]++;
+	fault_cnt++;
+}
+
+/* Evicts pages until the high watermark is reached, then sleeps until
+ * pageout_wake() is called again. */
+static void
+pageout_daemon (void *aux UNUSED) {
+	for (;;) {
+		sema_down (&pageout_sema);
+		while (palloc_user_free_cnt () < pageout_high_wm) {
+			// 더 쫓아낼 frame이 없거나 swap이 가득 찼으면 다음 wake까지 쉼
+			if (!vm_reclaim_frame ())
+				break;
+			daemon_reclaim_cnt++;
+		}
+		pageout_pending = false;
+	}
+}
+
+/* Prints reclaim statistics and the page fault latency histogram. */
+void
+pageout_print_stats (void) {
+	if (pageout_started)
+		printf ("Pageout: daemon on (low %zu, high %zu), ",
+				pageout_low_wm, pageout_high_wm);
+	else
+		printf ("Pageout: daemon off, ");
+	printf ("%lld frames reclaimed in background, %lld in page faults\n",
+			daemon_reclaim_cnt, direct_reclaim_cnt);
+
+	if (fault_cnt == 0)
+		return;
+	printf ("Page fault latency (%lld faults):\n", fault_cnt);
+	for (int i = 0; i < FAULT_HIST_BUCKETS; i++)
+		if (fault_hist[i] != 0)
+			printf ("  < 2^%-2d cycles: %lld\n", i + 1, fault_hist[i]);
+}
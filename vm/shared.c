@@ -0,0 +1,362 @@
+/* shared.c: Read-only frames shared between processes.
+ *
+ * Text segments of an executable never change while it runs (the file is
+ * write-denied), so every process running the same binary can map the same
+ * frame for a given (inode, offset, read length).  The first fault reads the
+ * page from disk; later faults, from this or any other process, only take a
+ * reference and install a read-only mapping.  The read length is part of the
+ * key because two segments can share a file page, e.g. the end of the text
+ * next to the start of rodata, and each zeroes a different tail of it.
+ *
+ * The same machinery backs the zero page: a single frame full of zeros that
+ * every untouched anonymous page maps on a read fault.  The first write goes
+ * through the write-protect fault path and gets a private copy.
+ *
+ * Anonymous pages that the ksm thread finds to be identical share a frame
+ * too.  Such a frame is keyed by a NULL inode and the checksum of its
+ * contents.
+ *
+ * The first fault on a text page inserts its frame marked loading and
+ * reads the file without shared_lock; other faults on the same page wait
+ * on text_loaded meanwhile, and faults on other pages go on as usual.
+ *
+ * Shared frames are not in the frame table, so they are never evicted;
+ * nothing records which pages map them, so they could not be unmapped
+ * anyway.  Text frames go away with the last process running the
+ * executable, and there are at most TEXT_FRAMES_MAX of them; past that,
+ * text pages are loaded as private frames that can be evicted.  The zero
+ * page is a single frame.  Merged frames are bounded by KSM_FRAMES_MAX,
+ * since any long-lived process can hold them; each still saves at least
+ * one private frame. */
+
+#include <stdio.h>
+#include <string.h>
+#include "intrinsic.h"
+#include "vm/shared.h"
+#include "vm/vm.h"
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "userprog/process.h"
+
+/* (inode, offset, read_bytes) -> struct shared_frame */
+static struct hash shared_frames;
+static struct lock shared_lock;
+/* Signaled, with shared_lock, whenever a text frame is done loading. */
+static struct condition text_loaded;
+
+/* 한 번에 있을 수 있는 공유 text frame 수의 상한 (4 MB) */
+#define TEXT_FRAMES_MAX 1024
+static size_t text_frame_cnt;
+
+// 통계: 디스크에서 읽은 text 페이지 수 / 캐시에서 바로 매핑한 페이지 수
+static long long text_read_cnt;
+static long long text_hit_cnt;
+// 통계: 위 두 경우에 fault 처리에 걸린 cycle 합 (exec 직후 text fault의 지연)
+static uint64_t text_read_cycles;
+static uint64_t text_hit_cycles;
+
+/* 한 번에 있을 수 있는 ksm frame 수의 상한 (2 MB) */
+#define KSM_FRAMES_MAX 512
+static size_t ksm_frame_cnt;
+
+/* 모든 프로세스가 공유하는 0으로 채워진 frame. 참조가 0이 되지 않으므로 반납되지 않음. */
+static struct shared_frame zero_frame;
+
+// 통계: zero page로 처리한 read fault 수
+static long long zero_map_cnt;
+
+static uint64_t
+shared_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct shared_frame *sf = hash_entry (e, struct shared_frame, elem);
+	return hash_bytes (&sf->inode, sizeof sf->inode) ^ hash_int (sf->offset)
+		^ hash_int (sf->read_bytes);
+}
+
+static bool
+shared_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct shared_frame *a = hash_entry (a_, struct shared_frame, elem);
+	const struct shared_frame *b = hash_entry (b_, struct shared_frame, elem);
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	if (a->offset != b->offset)
+		return a->offset < b->offset;
+	return a->read_bytes < b->read_bytes;
+}
+
+/* Initializes the shared frame table. */
+void
+vm_shared_init (void) {
+	hash_init (&shared_frames, shared_hash, shared_less, NULL);
+	lock_init (&shared_lock);
+	cond_init (&text_loaded);
+
+	zero_frame.frame.kva = palloc_get_page (PAL_USER | PAL_ZERO | PAL_ASSERT);
+	zero_frame.frame.page = NULL;
+	zero_frame.frame.shared = true;
+	zero_frame.frame.pinned = false;
+	zero_frame.inode = NULL;
+	zero_frame.offset = 0;
+	zero_frame.read_bytes = 0;
+	zero_frame.ref_cnt = 1;
+	zero_frame.loading = false;
+}
+
+/* Installs FRAME read-only for PAGE, which must not be mapped yet.
+ * An uninit PAGE is transmuted into its final type first.
+ * Caller holds shared_lock and has already counted the reference. */
+static bool
+install_shared (struct page *page, struct frame *frame) {
+	if (VM_TYPE (page->operations->type) == VM_UNINIT) {
+		struct uninit_page *uninit = &page->uninit;
+		if (!uninit->page_initializer (page, uninit->type, frame->kva))
+			return false;
+	}
+	page->frame = frame;
+	return pml4_set_page (page->owner->pml4, page->va, frame->kva, false);
+}
+
+/* Claims PAGE from the shared text cache if it is a read-only page of an
+ * ELF segment that is still waiting for lazy_load_segment.  Returns false if
+ * PAGE is not eligible or no frame is available; the caller then falls back
+ * to loading a private copy. */
+bool
+shared_claim_text (struct page *page) {
+	if (VM_TYPE (page->operations->type) != VM_UNINIT
+			|| page->uninit.init != lazy_load_segment || page->writable)
+		return false;
+
+	struct container *aux = page->uninit.aux;
+	struct shared_frame key;
+	uint64_t begin = rdtsc ();
+	key.inode = file_get_inode (aux->file);
+	key.offset = aux->offset;
+	key.read_bytes = aux->page_read_bytes;
+
+	lock_acquire (&shared_lock);
+	struct hash_elem *e = hash_find (&shared_frames, &key.elem);
+	struct shared_frame *sf;
+	if (e != NULL) {
+		sf = hash_entry (e, struct shared_frame, elem);
+		// 다른 fault가 읽는 중이면 기다림. 참조를 잡아 두어 실패해도 sf는 남음
+		sf->ref_cnt++;
+		while (sf->loading)
+			cond_wait (&text_loaded, &shared_lock);
+		if (sf->frame.kva == NULL) {
+			if (--sf->ref_cnt == 0)
+				free (sf);
+			lock_release (&shared_lock);
+			return false;
+		}
+		text_hit_cnt++;
+		text_hit_cycles += rdtsc () - begin;
+	} else {
+		// 처음 읽는 페이지: 공유용 frame을 새로 만들어 파일에서 채움
+		if (text_frame_cnt >= TEXT_FRAMES_MAX) {
+			lock_release (&shared_lock);
+			return false;
+		}
+		sf = malloc (sizeof *sf);
+		void *kva = palloc_get_page (PAL_USER);
+		if (sf == NULL || kva == NULL) {
+			free (sf);
+			if (kva != NULL)
+				palloc_free_page (kva);
+			lock_release (&shared_lock);
+			return false;
+		}
+		sf->frame.kva = kva;
+		sf->frame.page = NULL;
+		sf->frame.shared = true;
+		sf->frame.pinned = false;
+		sf->inode = inode_reopen (key.inode);
+		sf->offset = key.offset;
+		sf->read_bytes = key.read_bytes;
+		sf->ref_cnt = 1;
+		sf->loading = true;
+		hash_insert (&shared_frames, &sf->elem);
+		text_frame_cnt++;
+		lock_release (&shared_lock);
+
+		// 디스크를 읽는 동안 다른 페이지의 fault는 막지 않음
+		size_t read_bytes = aux->page_read_bytes;
+		bool read = file_read_at (aux->file, kva, read_bytes, aux->offset)
+			== (off_t) read_bytes;
+		if (read)
+			memset (kva + read_bytes, 0, PGSIZE - read_bytes);
+
+		lock_acquire (&shared_lock);
+		sf->loading = false;
+		cond_broadcast (&text_loaded, &shared_lock);
+		if (!read) {
+			// 기다리던 fault들은 kva가 NULL인 것을 보고 각자 private copy를 읽음
+			hash_delete (&shared_frames, &sf->elem);
+			text_frame_cnt--;
+			inode_close (sf->inode);
+			palloc_free_page (kva);
+			sf->frame.kva = NULL;
+			if (--sf->ref_cnt == 0)
+				free (sf);
+			lock_release (&shared_lock);
+			return false;
+		}
+		text_read_cnt++;
+		text_read_cycles += rdtsc () - begin;
+	}
+
+	bool success = install_shared (page, &sf->frame);
+	lock_release (&shared_lock);
+
+	if (!success)
+		shared_release (page);
+	return success;
+}
+
+/* Maps the shared FRAME into PAGE as well, e.g. for the child of fork. */
+bool
+shared_map (struct page *page, struct frame *frame) {
+	struct shared_frame *sf = (struct shared_frame *) frame;
+
+	ASSERT (frame->shared);
+
+	lock_acquire (&shared_lock);
+	sf->ref_cnt++;
+	bool success = install_shared (page, frame);
+	lock_release (&shared_lock);
+
+	if (!success)
+		shared_release (page);
+	return success;
+}
+
+/* Maps the zero frame read-only for PAGE, an untouched anonymous page that
+ * is being read.  The contents are those of a freshly zeroed page, so
+ * nothing has to be allocated until the first write. */
+bool
+shared_map_zero (struct page *page) {
+	if (!shared_map (page, &zero_frame.frame))
+		return false;
+	zero_map_cnt++;
+	return true;
+}
+
+/* Returns true if FRAME is the zero frame. */
+bool
+shared_is_zero (const struct frame *frame) {
+	return frame == &zero_frame.frame;
+}
+
+/* Drops PAGE's reference to its shared frame.  The frame is returned to
+ * palloc when the last page lets go of it. */
+void
+shared_release (struct page *page) {
+	struct shared_frame *sf = (struct shared_frame *) page->frame;
+
+	ASSERT (sf != NULL && sf->frame.shared);
+
+	// pml4_destroy가 공유 frame을 free하지 않도록 매핑부터 지움
+	if (page->owner->pml4 != NULL)
+		pml4_clear_page (page->owner->pml4, page->va);
+	page->frame = NULL;
+
+	lock_acquire (&shared_lock);
+	if (--sf->ref_cnt == 0) {
+		hash_delete (&shared_frames, &sf->elem);
+		if (sf->inode == NULL)
+			ksm_frame_cnt--;
+		else
+			text_frame_cnt--;
+		inode_close (sf->inode);
+		palloc_free_page (sf->frame.kva);
+		free (sf);
+	}
+	lock_release (&shared_lock);
+}
+
+/* Maps PAGE, whose private copy at KVA has CHECKSUM, to the merged frame
+ * with the same contents.  Returns false if there is no such frame.
+ * PAGE's private frame is left for the caller to free. */
+bool
+shared_ksm_merge (struct page *page, const void *kva, uint32_t checksum) {
+	struct shared_frame key;
+	key.inode = NULL;
+	key.offset = (off_t) checksum;
+	key.read_bytes = 0;
+
+	lock_acquire (&shared_lock);
+	struct hash_elem *e = hash_find (&shared_frames, &key.elem);
+	if (e == NULL) {
+		lock_release (&shared_lock);
+		return false;
+	}
+	struct shared_frame *sf = hash_entry (e, struct shared_frame, elem);
+	// checksum이 같아도 내용이 다를 수 있으므로 직접 비교
+	if (memcmp (sf->frame.kva, kva, PGSIZE) != 0) {
+		lock_release (&shared_lock);
+		return false;
+	}
+
+	struct frame *private = page->frame;
+	sf->ref_cnt++;
+	bool success = install_shared (page, &sf->frame);
+	if (!success) {
+		sf->ref_cnt--;
+		page->frame = private;
+	}
+	lock_release (&shared_lock);
+	return success;
+}
+
+/* Turns KVA, the contents of PAGE's private frame, into a merged frame
+ * with CHECKSUM and maps PAGE to it.  Returns false if a merged frame with
+ * the same checksum exists already, there are KSM_FRAMES_MAX merged frames
+ * or memory allocation fails; PAGE keeps its private frame then.  On
+ * success KVA belongs to the merged frame. */
+bool
+shared_ksm_insert (struct page *page, void *kva, uint32_t checksum) {
+	struct shared_frame *sf = malloc (sizeof *sf);
+	if (sf == NULL)
+		return false;
+	sf->frame.kva = kva;
+	sf->frame.page = NULL;
+	sf->frame.shared = true;
+	sf->frame.pinned = false;
+	sf->inode = NULL;
+	sf->offset = (off_t) checksum;
+	sf->read_bytes = 0;
+	sf->ref_cnt = 1;
+	sf->loading = false;
+
+	lock_acquire (&shared_lock);
+	if (ksm_frame_cnt >= KSM_FRAMES_MAX
+			|| hash_insert (&shared_frames, &sf->elem) != NULL) {
+		lock_release (&shared_lock);
+		free (sf);
+		return false;
+	}
+	struct frame *private = page->frame;
+	bool success = install_shared (page, &sf->frame);
+	if (!success) {
+		hash_delete (&shared_frames, &sf->elem);
+		free (sf);
+		page->frame = private;
+	} else
+		ksm_frame_cnt++;
+	lock_release (&shared_lock);
+	return success;
+}
+
+/* Prints statistics of the shared text cache. */
+void
+shared_print_stats (void) {
+	printf ("Shared text: %lld pages read, %lld pages shared (%lld kB saved)\n",
+			text_read_cnt, text_hit_cnt, text_hit_cnt * PGSIZE / 1024);
+	printf ("Shared text: %llu cycles per page read, %llu per page shared "
+			"(average)\n",
+			text_read_cnt ? (unsigned long long) (text_read_cycles / text_read_cnt) : 0,
+			text_hit_cnt ? (unsigned long long) (text_hit_cycles / text_hit_cnt) : 0);
+	printf ("Zero page: %lld read faults mapped\n", zero_map_cnt);
+}
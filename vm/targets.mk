@@ -2,4 +2,9 @@ vm_SRC = vm/vm.c          # Main api proxy
 vm_SRC += vm/uninit.c     # Uninitialized page
 vm_SRC += vm/anon.c       # Anonymous page
 vm_SRC += vm/file.c       # File mapped page
+vm_SRC += vm/shared.c     # Shared read-only frames
+vm_SRC += vm/pageout.c    # Background page reclaim
+vm_SRC += vm/advise.c     # madvise and prefetch
+vm_SRC += vm/ksm.c        # Same-page merging
+vm_SRC += vm/launch.c     # Launch prefetch
 vm_SRC += vm/inspect.c    # Testing utility
@@ -8,6 +8,7 @@
  * function.
  * */
 
+#include <string.h>
 #include "vm/vm.h"
 #include "vm/uninit.h"
 
@@ -51,6 +52,9 @@ static bool uninit_initialize (struct page *page, void *kva) {
 	void *aux = uninit->aux;
 
 	/* TODO: You may need to fix this function. */
+	// 초기화 함수가 없는 페이지(stack, bss)는 0으로 채워진 상태로 시작
+	if (init == NULL)
+		memset (kva, 0, PGSIZE);
 	return uninit->page_initializer (page, uninit->type, kva) && (init ? init (page, aux) : true);
 }
 
@@ -1,14 +1,37 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
+#include <stdio.h>
+#include <string.h>
+#include "intrinsic.h"
 #include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
 #include "vm/vm.h"
+#include "vm/advise.h"
 #include "vm/inspect.h"
+#include "vm/ksm.h"
+#include "vm/launch.h"
+#include "vm/pageout.h"
+#include "vm/shared.h"
 #include "userprog/process.h"
 
 // global variables
 struct list frame_table;
 struct list_elem* start;
 
+// frame_table, clock hand(start), frame의 pinned 필드 보호. 디스크 I/O 중에는 잡지 않음
+static struct lock frame_lock;
+// eviction은 한 번에 하나씩. 쫓겨나는 중인 페이지에 접근하는 스레드는 이 lock으로 끝나기를 기다림
+static struct lock evict_lock;
+
+// 통계: write-protect fault에서 공유 frame을 복사한 횟수
+static long long wp_copy_cnt;
+// 통계: 2 MB 페이지로 매핑한 횟수 / 조건은 맞았지만 2 MB를 얻지 못해 4 KB로 처리한 횟수
+static long long huge_map_cnt;
+static long long huge_fallback_cnt;
+// 통계: RSS 상한을 넘어 자기 frame에서 쫓아낸 횟수
+static long long local_reclaim_cnt;
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void
@@ -23,6 +46,29 @@ vm_init (void) {
 	/* TODO: Your code goes here. */
 	list_init(&frame_table);
 	start = list_begin(&frame_table);
+	lock_init(&frame_lock);
+	lock_init(&evict_lock);
+	vm_shared_init();
+	pageout_init();
+	vm_advise_init();
+	vm_ksm_init();
+	vm_launch_init();
+}
+
+/* Prints statistics of the virtual memory subsystem. */
+void
+vm_print_stats (void) {
+	anon_print_stats ();
+	shared_print_stats ();
+	printf ("Write-protect faults: %lld pages copied\n", wp_copy_cnt);
+	printf ("Huge pages: %lld mapped, %lld fell back to 4 kB, %lld split\n",
+			huge_map_cnt, huge_fallback_cnt, pml4_huge_split_cnt ());
+	printf ("RSS limits: %lld pages reclaimed locally\n", local_reclaim_cnt);
+	pageout_print_stats ();
+	file_print_stats ();
+	advise_print_stats ();
+	ksm_print_stats ();
+	launch_print_stats ();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -40,9 +86,12 @@ page_get_type (struct page *page) {
 }
 
 /* Helpers */
-static struct frame *vm_get_victim (void);
+static struct frame *vm_get_victim (struct thread *owner);
 static bool vm_do_claim_page (struct page *page);
-static struct frame *vm_evict_frame (void);
+static bool vm_claim_pinned (struct page *page);
+static struct frame *vm_pin_resident_frame (struct page *page);
+static bool vm_claim_huge (struct page *page);
+static struct frame *vm_evict_frame (struct thread *owner);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -71,16 +120,24 @@ bool vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writab
             case VM_FILE:
                 initializer = file_backed_initializer;
                 break;
+            case VM_PAGE_CACHE:
+                initializer = page_cache_initializer;
+                break;
 		}
 
         uninit_new(page, upage, init, type, aux, initializer);
 
         // page member 초기화
         page->writable = writable;
+        page->owner = thread_current();
+        page->advice = 0;
         // hex_dump(page->va, page->va, PGSIZE, true);
 
 		/* TODO: Insert the page into the spt. */
-		return spt_insert_page(spt, page);
+		lock_acquire(&spt->lock);
+		bool success = spt_insert_page(spt, page);
+		lock_release(&spt->lock);
+		return success;
 	}
 err:
 	return false;
@@ -90,13 +147,12 @@ err:
 struct page *spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 	// struct page  *page = NULL;
 	/* TODO: Fill this function. */
-    struct page* page = (struct page*)malloc(sizeof(struct page));
+    // 검색용 키는 va만 쓰므로 스택에 둠 (2 MB 범위를 훑을 때 malloc 512번을 피함)
+    struct page key;
     struct hash_elem *e;
 
-    page->va = pg_round_down(va);  // va가 가리키는 가상 페이지의 시작 포인트(오프셋이 0으로 설정된 va) 반환
-    e = hash_find(&spt->pages, &page->hash_elem);	// hash_elem 구조체 얻음
-
-    free(page);
+    key.va = pg_round_down(va);  // va가 가리키는 가상 페이지의 시작 포인트(오프셋이 0으로 설정된 va) 반환
+    e = hash_find(&spt->pages, &key.hash_elem);	// hash_elem 구조체 얻음
 
     return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;	// 존재하지 않는다면 NULL 리턴
 }
@@ -118,65 +174,186 @@ spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
 	return true;
 }
 
-/* Get the struct frame, that will be evicted. */
+/* Get the struct frame, that will be evicted: one of OWNER's frames, or
+ * any frame if OWNER is NULL.
+ * Caller holds frame_lock.  Returns NULL if every such frame is pinned. */
 static struct frame *
-vm_get_victim (void) {
-	struct frame *victim = NULL;
+vm_get_victim (struct thread *owner) {
     /* TODO: The policy for eviction is up to you. */
-    struct thread *curr = thread_current();
-    struct list_elem *e = start;
-
-    for (start = e; start != list_end(&frame_table); start = list_next(start)) {
-        victim = list_entry(start, struct frame, frame_elem);
-        if (pml4_is_accessed(curr->pml4, victim->page->va))
-            pml4_set_accessed (curr->pml4, victim->page->va, 0);
+    // clock 알고리즘: accessed bit가 서 있으면 지우고 넘어감. 최대 두 바퀴
+    // accessed bit는 frame을 가진 페이지의 주인 pml4에서 확인해야 함
+    size_t cnt = list_size(&frame_table);
+
+    for (size_t i = 0; i < 2 * cnt; i++) {
+        if (start == list_end(&frame_table))
+            start = list_begin(&frame_table);
+        struct frame *victim = list_entry(start, struct frame, frame_elem);
+        start = list_next(start);
+
+        if (victim->pinned || victim->page == NULL)
+            continue;
+        // 로컬 회수는 다른 프로세스의 accessed bit를 건드리지 않고 지나감
+        if (owner != NULL && victim->page->owner != owner)
+            continue;
+        // swap in 뒤에 수정된 익명 페이지의 slot은 지나가면서 반납
+        if (VM_TYPE(victim->page->operations->type) == VM_ANON)
+            anon_drop_stale_slot(victim->page);
+        uint64_t *pml4 = victim->page->owner->pml4;
+        if (pml4_is_accessed(pml4, victim->page->va))
+            pml4_set_accessed (pml4, victim->page->va, 0);
         else
             return victim;
     }
+    return NULL;
+}
 
-    for (start = list_begin(&frame_table); start != e; start = list_next(start)) {
-        victim = list_entry(start, struct frame, frame_elem);
-        if (pml4_is_accessed(curr->pml4, victim->page->va))
-            pml4_set_accessed (curr->pml4, victim->page->va, 0);
-        else
-            return victim;
+/* Evict one page, one of OWNER's if OWNER is not NULL, and return the
+ * corresponding frame.
+ * Return NULL on error.
+ * The frame stays in the frame table and is returned pinned. */
+static struct frame *
+vm_evict_frame (struct thread *owner) {
+    lock_acquire(&evict_lock);
+
+    lock_acquire(&frame_lock);
+	struct frame *victim = vm_get_victim(owner);
+    if (victim != NULL)
+        victim->pinned = true;
+    lock_release(&frame_lock);
+
+    if (victim == NULL) {
+        lock_release(&evict_lock);
+        return NULL;
+    }
+
+    /* TODO: swap out the victim and return the evicted frame. */
+    // swap_out은 매핑부터 해제하므로 쓰는 동안 주인이 접근하면 fault 후 evict_lock에서 기다림
+    bool success = swap_out(victim->page);
+
+    lock_acquire(&frame_lock);
+    if (success) {
+        // 쫓겨난 페이지는 더 이상 frame을 가지지 않음
+        victim->page->owner->rss--;
+        victim->page->frame = NULL;
+        victim->page = NULL;
     }
+    else
+        victim->pinned = false;
+    lock_release(&frame_lock);
+
+    lock_release(&evict_lock);
+    return success ? victim : NULL;
+}
+
+/* Takes FRAME, just evicted, out of the frame table and gives its memory
+ * back to palloc. */
+static void
+vm_drop_frame (struct frame *frame) {
+    lock_acquire(&frame_lock);
+    if (start == &frame->frame_elem)
+        start = list_next(start);
+    list_remove(&frame->frame_elem);
+    lock_release(&frame_lock);
+
+    palloc_free_page(frame->kva);
+    free(frame);
+}
 
-    return victim;
+/* Evicts one page and gives its frame back to palloc.
+ * Used by the pageout daemon.  Returns false if nothing could be evicted. */
+bool
+vm_reclaim_frame (void) {
+    struct frame *frame = vm_evict_frame(NULL);
+
+    if (frame == NULL)
+        return false;
+    vm_drop_frame(frame);
+    return true;
+}
+
+/* Limits the current process to PAGES private frames, or lifts the limit
+ * if PAGES is 0, and evicts its pages down to the new limit. */
+void
+vm_set_rss_limit (size_t pages) {
+    struct thread *t = thread_current();
+
+    t->rss_limit = pages;
+    while (pages != 0 && t->rss > pages) {
+        struct frame *frame = vm_evict_frame(t);
+        if (frame == NULL)
+            break;
+        local_reclaim_cnt++;
+        vm_drop_frame(frame);
+    }
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
+/* Wraps KVA, a page from the user pool, in a new frame table entry.
+ * The frame is returned pinned. */
 static struct frame *
-vm_evict_frame (void) {
-	struct frame *victim = vm_get_victim();
-    /* TODO: swap out the victim and return the evicted frame. */
+vm_new_frame (void *kva) {
+	struct frame *frame = (struct frame*)malloc(sizeof(struct frame));
+	frame->kva = kva;
+    frame->page = NULL;
+    frame->shared = false;
+    frame->pinned = true;
 
-    swap_out(victim->page);
+    lock_acquire(&frame_lock);
+    list_push_back (&frame_table, &frame->frame_elem);
+    lock_release(&frame_lock);
+    return frame;
+}
 
-    return victim;
+/* Links FRAME and PAGE and counts FRAME in the RSS of PAGE's owner. */
+static void
+vm_link_frame (struct frame *frame, struct page *page) {
+	frame->page = page;
+	page->frame = frame;
+	lock_acquire(&frame_lock);
+	page->owner->rss++;
+	lock_release(&frame_lock);
 }
 
-/* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
-static struct frame * vm_get_frame (void) {
+/* palloc() and get frame for a page of OWNER. If there is no available page,
+ * evict the page and return it. This always return valid address. That is,
+ * if the user pool memory is full, this function evicts the frame to get the
+ * available memory space.  If OWNER is at its RSS limit, one of its own
+ * pages is evicted instead, even when memory is free.
+ * The frame is returned pinned; the caller unpins it once the page is
+ * mapped. */
+static struct frame * vm_get_frame (struct thread *owner) {
 	// struct frame *frame = NULL;
 	/* TODO: Fill this function. */
-	struct frame *frame = (struct frame*)malloc(sizeof(struct frame));
-	
-	frame->kva = palloc_get_page(PAL_USER);
-    if(frame->kva == NULL)
-    {
-        frame = vm_evict_frame();
-        frame->page = NULL;
+	struct frame *frame;
+
+	// 상한을 넘은 프로세스는 다른 프로세스의 working set 대신 자기 페이지를 내놓음.
+	// 자기 frame이 전부 pin 되어 있으면 평소처럼 할당
+	if (owner->rss_limit != 0 && owner->rss >= owner->rss_limit) {
+		frame = vm_evict_frame(owner);
+		if (frame != NULL) {
+			local_reclaim_cnt++;
+			return frame;
+		}
+	}
+
+	void *kva = palloc_get_page(PAL_USER);
+
+	// 아무도 쓰지 않는 page cache 페이지가 있으면 프로세스 페이지보다 먼저 내줌
+	if (kva == NULL && page_cache_reclaim())
+		kva = palloc_get_page(PAL_USER);
 
+    if(kva == NULL)
+    {
+        // pageout daemon이 따라잡지 못함 -> fault 처리 중에 직접 회수
+        frame = vm_evict_frame(NULL);
+        if (frame == NULL)
+            PANIC ("vm_get_frame: out of frames and swap slots");
+        pageout_count_direct();
+        pageout_wake();
         return frame;
     }
-    list_push_back (&frame_table, &frame->frame_elem);
 
-    frame->page = NULL;
+	frame = vm_new_frame(kva);
+    pageout_wake();
 
 	ASSERT (frame != NULL);
 	ASSERT (frame->page == NULL);
@@ -185,20 +362,151 @@ static struct frame * vm_get_frame (void) {
 
 /* Growing the stack. */
 static void vm_stack_growth (void *addr UNUSED) {
+    // frame은 fault 처리에서 읽기/쓰기에 따라 zero page 또는 새 frame으로 할당
     if(vm_alloc_page(VM_ANON | VM_MARKER_0, addr, 1))
-    {
-        vm_claim_page(addr);
         thread_current()->stack_bottom -= PGSIZE;   // 스택은 위에서부터 쌓기 때문에 주소값 위치를 페이지 사이즈씩 마이너스함
-    }
 }
 
 /* Handle the fault on write_protected page */
 static bool
 vm_handle_wp (struct page *page UNUSED) {
+	struct frame *shared = page->frame;
+
+	// 공유 frame(zero page 등)을 매핑한 쓰기 가능 페이지만 처리. 나머지는 진짜 권한 위반
+	if (!page->writable || shared == NULL || !shared->shared)
+		return false;
+	// zero page에 처음 쓰는 경우 주변 2 MB 전체를 huge page로 채울 수 있는지 먼저 확인
+	if (shared_is_zero (shared) && vm_claim_huge (page))
+		return true;
+
+	struct frame *frame = vm_get_frame (page->owner);
+	if (shared_is_zero (shared))
+		memset (frame->kva, 0, PGSIZE);
+	else
+		memcpy (frame->kva, shared->kva, PGSIZE);
+	shared_release (page);
+
+	vm_link_frame (frame, page);
+	wp_copy_cnt++;
+	bool success = pml4_set_page (page->owner->pml4, page->va, frame->kva, true);
+	frame->pinned = false;
+	return success;
+}
+
+/* Returns true if PAGE is an anonymous page that was never touched. */
+static bool
+vm_is_untouched_anon (struct page *page) {
+	return VM_TYPE (page->operations->type) == VM_UNINIT
+		&& VM_TYPE (page->uninit.type) == VM_ANON && page->uninit.init == NULL;
+}
+
+/* Claims PAGE on a fault.  A read of an anonymous page that was never
+ * touched maps the zero page instead of allocating a frame. */
+static bool
+vm_claim_on_fault (struct page *page, bool write) {
+	if (vm_is_untouched_anon (page)) {
+		if (!write)
+			return shared_map_zero (page);
+		if (page->writable && vm_claim_huge (page))
+			return true;
+	}
+	return vm_do_claim_page (page);
+}
+
+/* Returns true if PAGE reads as zeros and has no frame of its own: an
+ * untouched anonymous page, or one that has only mapped the zero page. */
+static bool
+vm_is_zero_anon (struct page *page) {
+	return vm_is_untouched_anon (page)
+		|| (page->frame != NULL && shared_is_zero (page->frame));
+}
+
+/* Backs the whole 2 MB region around PAGE with a single huge page if
+ * every page in it is a writable anonymous page that still reads as
+ * zeros, as in a large heap array.  Each 4 KB page still gets its own
+ * frame table entry, so eviction, madvise and exit work page by page and
+ * split the mapping when they touch it.
+ * Returns false if the region does not qualify or no aligned 2 MB block
+ * is free; the caller then claims a 4 KB frame as usual.
+ * Caller holds the owner's spt lock. */
+static bool
+vm_claim_huge (struct page *page) {
+	struct supplemental_page_table *spt = &page->owner->spt;
+	uint64_t *pml4 = page->owner->pml4;
+	void *base = hpg_round_down (page->va);
+	uint64_t zero_mapped[HPG_PAGES / 64] = { 0 };
+
+	// 메모리가 부족하면 곧 쪼개져서 쫓겨날 것이므로 시도하지 않음
+	if (palloc_user_free_cnt () < 2 * HPG_PAGES)
+		return false;
+	// RSS 상한을 넘게 되는 경우도 마찬가지
+	if (page->owner->rss_limit != 0
+			&& page->owner->rss + HPG_PAGES > page->owner->rss_limit)
+		return false;
+	for (size_t i = 0; i < HPG_PAGES; i++) {
+		struct page *p = spt_find_page (spt, base + i * PGSIZE);
+		if (p == NULL || !p->writable || !vm_is_zero_anon (p))
+			return false;
+	}
+
+	uint8_t *kva = palloc_get_aligned (PAL_USER | PAL_ZERO, HPG_PAGES, HPG_PAGES);
+	if (kva == NULL) {
+		huge_fallback_cnt++;
+		return false;
+	}
+	pageout_wake ();
+
+	// 2 MB 매핑은 범위 안에 매핑된 4 KB 페이지가 없어야 하므로 zero page 매핑부터 걷어냄
+	for (size_t i = 0; i < HPG_PAGES; i++) {
+		struct page *p = spt_find_page (spt, base + i * PGSIZE);
+		if (p->frame != NULL) {
+			shared_release (p);
+			zero_mapped[i / 64] |= 1ULL << (i % 64);
+		}
+	}
+	if (!pml4_set_huge_page (pml4, base, kva, true)) {
+		for (size_t i = 0; i < HPG_PAGES; i++)
+			if (zero_mapped[i / 64] & (1ULL << (i % 64)))
+				shared_map_zero (spt_find_page (spt, base + i * PGSIZE));
+		palloc_free_multiple (kva, HPG_PAGES);
+		huge_fallback_cnt++;
+		return false;
+	}
+
+	for (size_t i = 0; i < HPG_PAGES; i++) {
+		struct page *p = spt_find_page (spt, base + i * PGSIZE);
+		struct frame *frame = vm_new_frame (kva + i * PGSIZE);
+
+		vm_link_frame (frame, p);
+		// uninit 페이지는 anon으로 바꿈. 내용은 PAL_ZERO로 이미 0
+		if (VM_TYPE (p->operations->type) == VM_UNINIT)
+			p->uninit.page_initializer (p, p->uninit.type, frame->kva);
+
+		lock_acquire (&frame_lock);
+		frame->pinned = false;
+		lock_release (&frame_lock);
+	}
+	huge_map_cnt++;
+	return true;
+}
+
+/* Claims the page at VA in SPT ahead of use, for the prefetch thread.
+ * Returns true if a page was brought in. */
+bool
+vm_prefetch_page (struct supplemental_page_table *spt, void *va) {
+	bool success = false;
+
+	lock_acquire(&spt->lock);
+	struct page *page = spt_find_page(spt, va);
+	// 이미 올라와 있거나 쫓겨나는 중인 페이지, 0으로 읽힐 anon 페이지는 건너뜀
+	if (page != NULL && page->frame == NULL && !vm_is_untouched_anon(page))
+		success = vm_do_claim_page(page);
+	lock_release(&spt->lock);
+	return success;
 }
 
 /* Return true on success */
-bool vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
+static bool vm_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
 		bool user UNUSED, bool write UNUSED, bool not_present UNUSED) {
 	struct supplemental_page_table *spt UNUSED = &thread_current ()->spt;
 	// struct page *page = NULL;
@@ -208,19 +516,52 @@ bool vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED,
         return false;
 	}
 
-    void *rsp_stack = is_kernel_vaddr(f->rsp) ? thread_current()->rsp_stack : f->rsp;
-    if (not_present){
-        if (!vm_claim_page(addr)) {
-            if (rsp_stack - 8 <= addr && USER_STACK - 0x100000 <= addr && addr <= USER_STACK) {
-                vm_stack_growth(thread_current()->stack_bottom - PGSIZE);
-                return true;
-            }
+    struct page *page = spt_find_page(spt, addr);
+    if (page == NULL && not_present) {
+        void *rsp_stack = is_kernel_vaddr(f->rsp) ? thread_current()->rsp_stack : f->rsp;
+        if (!(rsp_stack - 8 <= addr && USER_STACK - 0x100000 <= addr && addr <= USER_STACK))
             return false;
+        vm_stack_growth(thread_current()->stack_bottom - PGSIZE);
+        page = spt_find_page(spt, thread_current()->stack_bottom);
+    }
+    if (page == NULL)
+        return false;
+
+    bool success;
+    lock_acquire(&spt->lock);
+    // 매핑된 read-only 페이지에 쓰기 -> copy-on-write 대상인지 확인
+    if (!not_present)
+        success = write && vm_handle_wp(page);
+    // prefetch worker가 먼저 올려 두었으면 할 일이 없음
+    else if (pml4_get_page(thread_current()->pml4, page->va) != NULL)
+        success = true;
+    else {
+        // 매핑이 없는데 frame이 있으면 쫓겨나는 중이거나 ksm이 검사 중 -> 끝나기를 기다림
+        if (page->frame != NULL && !page->frame->shared) {
+            lock_acquire(&evict_lock);
+            lock_release(&evict_lock);
         }
+        // 기다리는 동안 같은 내용의 공유 frame으로 합쳐졌으면 이미 매핑되어 있음.
+        // 쓰기였다면 다시 실행할 때 write-protect fault로 복사됨
+        if (pml4_get_page(thread_current()->pml4, page->va) != NULL)
+            success = true;
         else
-            return true;
+            success = vm_claim_on_fault(page, write);
     }
-    return false;
+    lock_release(&spt->lock);
+
+    if (success && not_present)
+        advise_fault(page);
+    return success;
+}
+
+/* Handles a page fault and records how long it took. */
+bool vm_try_handle_fault (struct intr_frame *f, void *addr,
+		bool user, bool write, bool not_present) {
+	uint64_t begin = rdtsc ();
+	bool success = vm_handle_fault (f, addr, user, write, not_present);
+	pageout_record_fault (rdtsc () - begin);
+	return success;
 }
 
 /* Free the page.
@@ -247,30 +588,271 @@ bool vm_claim_page (void *va UNUSED) {
 /* Claim the PAGE and set up the mmu. */
 // 가상 주소와 물리주소 매핑( 성공, 실패 여부 리턴해줌 )
 static bool vm_do_claim_page (struct page *page) {
-	struct frame *frame = vm_get_frame ();
+	if (!vm_claim_pinned(page))
+		return false;
+	page->frame->pinned = false;
+	return true;
+}
+
+/* Claims PAGE like vm_do_claim_page but leaves its frame pinned, so the
+ * caller can keep filling it without racing the pageout daemon. */
+static bool vm_claim_pinned (struct page *page) {
+	// 실행 파일의 read-only 영역은 같은 파일을 실행 중인 프로세스들과 frame을 공유
+	if (shared_claim_text(page))
+		return true;
+	// 파일 매핑은 page cache의 페이지를 그대로 매핑 (frame table 밖이라 pin 할 것이 없음)
+	if (page_get_type(page) == VM_PAGE_CACHE)
+		return page_cache_map(page);
+
+	struct frame *frame = vm_get_frame (page->owner);
 
 	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+	vm_link_frame (frame, page);
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
-	if (install_page(page->va, frame->kva, page->writable)) {	// 유저페이지가 이미 매핑되었거나 메모리 할당 실패 시 false
-        return swap_in(page, frame->kva);
+	// fork 중에는 부모의 페이지를 swap in 할 수도 있으므로 현재 스레드가 아닌 주인의 pml4에 매핑
+	uint64_t *pml4 = page->owner->pml4;
+	if (pml4_get_page(pml4, page->va) == NULL
+			&& pml4_set_page(pml4, page->va, frame->kva, page->writable)) {	// 유저페이지가 이미 매핑되었거나 메모리 할당 실패 시 false
+        if (swap_in(page, frame->kva))
+            return true;
     }
+    frame->pinned = false;
     return false;
 }
 
+/* PAGE가 가지고 있는 frame을 반납한다.
+ * 주인의 page table에서 매핑을 지우고 frame table에서 뺀 뒤 메모리를 palloc에 돌려준다.
+ * pml4_destroy가 같은 frame을 한 번 더 free하지 않도록 PTE를 먼저 지워야 함. */
+void vm_free_frame (struct page *page) {
+	struct frame *frame = page->frame;
+
+	if (frame == NULL)
+		return;
+
+	if (frame->shared) {
+		shared_release(page);
+		return;
+	}
+
+	lock_acquire(&frame_lock);
+	// pageout daemon이 쫓아내는 중이면 끝날 때까지 기다림 (끝나면 page->frame은 NULL)
+	while (frame->pinned) {
+		lock_release(&frame_lock);
+		lock_acquire(&evict_lock);
+		lock_release(&evict_lock);
+		lock_acquire(&frame_lock);
+		frame = page->frame;
+		if (frame == NULL) {
+			lock_release(&frame_lock);
+			return;
+		}
+	}
+	// 기다리는 동안 ksm이 공유 frame으로 합쳤을 수 있음
+	if (frame->shared) {
+		lock_release(&frame_lock);
+		shared_release(page);
+		return;
+	}
+
+	if (page->owner->pml4 != NULL)
+		pml4_clear_page(page->owner->pml4, page->va);
+
+	// clock hand가 지워질 frame을 가리키고 있으면 다음 frame으로 넘김
+	if (start == &frame->frame_elem)
+		start = list_next(start);
+	list_remove(&frame->frame_elem);
+	page->owner->rss--;
+	// frame_lock을 놓기 전에 끊어야 ksm 등이 vm_try_pin_frame으로 해제된 frame을 잡지 않음
+	page->frame = NULL;
+	lock_release(&frame_lock);
+
+	palloc_free_page(frame->kva);
+	free(frame);
+}
+
+/* Pins up to MAX resident frames whose pages pass FILTER and stores the
+ * pages in PAGES.  Returns the number stored.  evict_lock stays held until
+ * vm_unpin_frames(), so threads that need one of the pages sleep on it
+ * instead of spinning, just as they do for an eviction. */
+size_t
+vm_pin_frames (bool (*filter) (struct page *, void *), void *aux,
+		struct page **pages, size_t max) {
+	size_t cnt = 0;
+
+	lock_acquire(&evict_lock);
+	lock_acquire(&frame_lock);
+	for (struct list_elem *e = list_begin(&frame_table);
+			e != list_end(&frame_table) && cnt < max; e = list_next(e)) {
+		struct frame *frame = list_entry(e, struct frame, frame_elem);
+		if (frame->pinned || frame->page == NULL || !filter(frame->page, aux))
+			continue;
+		frame->pinned = true;
+		pages[cnt++] = frame->page;
+	}
+	lock_release(&frame_lock);
+	return cnt;
+}
+
+/* Unpins the CNT pages pinned by vm_pin_frames(). */
+void
+vm_unpin_frames (struct page **pages, size_t cnt) {
+	lock_acquire(&frame_lock);
+	for (size_t i = 0; i < cnt; i++)
+		pages[i]->frame->pinned = false;
+	lock_release(&frame_lock);
+	lock_release(&evict_lock);
+}
+
+/* Adds CURSOR, a placeholder that never holds a page, to the frame table
+ * for vm_pin_frames_after().  It stays pinned so that nothing evicts or
+ * frees it. */
+void
+vm_add_frame_cursor (struct frame *cursor) {
+	cursor->kva = NULL;
+	cursor->page = NULL;
+	cursor->shared = false;
+	cursor->pinned = true;
+
+	lock_acquire(&frame_lock);
+	list_push_back(&frame_table, &cursor->frame_elem);
+	lock_release(&frame_lock);
+}
+
+/* Like vm_pin_frames(), but looks at no more than MAX frames, starting
+ * after CURSOR and wrapping around at the end of the frame table.  CURSOR
+ * is moved past the last frame looked at, so repeated calls walk the whole
+ * table a slice at a time.  evict_lock stays held until vm_unpin_frames(). */
+size_t
+vm_pin_frames_after (struct frame *cursor,
+		bool (*filter) (struct page *, void *), void *aux,
+		struct page **pages, size_t max) {
+	size_t cnt = 0;
+
+	lock_acquire(&evict_lock);
+	lock_acquire(&frame_lock);
+	struct list_elem *e = list_next(&cursor->frame_elem);
+	for (size_t seen = 0; seen < max; seen++) {
+		if (e == list_end(&frame_table))
+			e = list_begin(&frame_table);
+		if (e == &cursor->frame_elem)   // 한 바퀴 다 돎
+			break;
+		struct frame *frame = list_entry(e, struct frame, frame_elem);
+		e = list_next(e);
+		if (frame->pinned || frame->page == NULL || !filter(frame->page, aux))
+			continue;
+		frame->pinned = true;
+		pages[cnt++] = frame->page;
+	}
+
+	if (e != &cursor->frame_elem) {
+		if (start == &cursor->frame_elem)
+			start = list_next(start);
+		list_remove(&cursor->frame_elem);
+		list_insert(e, &cursor->frame_elem);
+	}
+	lock_release(&frame_lock);
+	return cnt;
+}
+
+/* Pins PAGE's frame if it is resident, private and not pinned by anyone
+ * else.  Caller holds evict_lock through vm_pin_frames_after(). */
+bool
+vm_try_pin_frame (struct page *page) {
+	bool pinned = false;
+
+	lock_acquire(&frame_lock);
+	struct frame *frame = page->frame;
+	if (frame != NULL && !frame->shared && !frame->pinned) {
+		frame->pinned = true;
+		pinned = true;
+	}
+	lock_release(&frame_lock);
+	return pinned;
+}
+
+/* Unpins FRAME, pinned by vm_try_pin_frame(). */
+void
+vm_unpin_frame (struct frame *frame) {
+	lock_acquire(&frame_lock);
+	frame->pinned = false;
+	lock_release(&frame_lock);
+}
+
+/* Takes FRAME, a pinned private frame, out of the frame table and returns
+ * its memory without freeing it, e.g. to turn it into a shared frame.
+ * The page that pointed at FRAME must be given another frame. */
+void *
+vm_detach_frame (struct frame *frame) {
+	void *kva = frame->kva;
+
+	ASSERT (frame->pinned && !frame->shared);
+
+	lock_acquire(&frame_lock);
+	if (start == &frame->frame_elem)
+		start = list_next(start);
+	list_remove(&frame->frame_elem);
+	frame->page->owner->rss--;
+	lock_release(&frame_lock);
+
+	free(frame);
+	return kva;
+}
+
+/* Pins and returns PAGE's frame, or returns NULL if PAGE is not resident.
+ * Waits for an eviction of PAGE that is already in progress. */
+static struct frame *
+vm_pin_resident_frame (struct page *page) {
+	lock_acquire(&frame_lock);
+	while (page->frame != NULL && page->frame->pinned) {
+		lock_release(&frame_lock);
+		lock_acquire(&evict_lock);
+		lock_release(&evict_lock);
+		lock_acquire(&frame_lock);
+	}
+	struct frame *frame = page->frame;
+	if (frame != NULL)
+		frame->pinned = true;
+	lock_release(&frame_lock);
+	return frame;
+}
+
+/* Removes PML4's mappings in [START, END) with pml4_clear_range(), which
+ * frees the page tables that become empty.  Eviction, local reclaim and
+ * ksm walk other processes' page tables with evict_lock held, so holding
+ * it here keeps them out of tables that are being freed. */
+void
+vm_clear_range (uint64_t *pml4, void *start, void *end) {
+	lock_acquire(&evict_lock);
+	pml4_clear_range(pml4, start, end);
+	lock_release(&evict_lock);
+}
 
 /* Initialize new supplemental page table */
 void
 supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
 	hash_init(&spt->pages, page_hash, page_less, NULL);
+	lock_init(&spt->lock);
 }
 
+static bool spt_copy_pages (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src);
+
 /* Copy supplemental page table from src to dst */
 bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
+	// 복사하는 동안 prefetch worker가 부모 페이지의 상태를 바꾸지 못하게 함
+	lock_acquire(&src->lock);
+	bool success = spt_copy_pages(dst, src);
+	lock_release(&src->lock);
+	return success;
+}
+
+/* Copies every page of SRC into DST.  Caller holds SRC's lock. */
+static bool
+spt_copy_pages (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src) {
 	struct hash_iterator i;
 	struct hash * src_hash = &src->pages;
 	hash_first (&i, src_hash);
@@ -286,22 +868,46 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 			if (!vm_alloc_page_with_initializer(type, upage, writable, init, aux))
 				return false;
 		}
-		else if(type == VM_ANON) {
-			if (!vm_alloc_page_with_initializer(type, upage, writable, init, aux))
+		else if(type == VM_ANON && p->frame != NULL && p->frame->shared) {
+			// 공유 중인 text 페이지는 자식도 같은 frame을 매핑
+			if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, NULL))
 				return false;
-			if (!vm_claim_page(upage))
+			if (!shared_map(spt_find_page(dst, upage), p->frame))
 				return false;
+		}
+		else if(type == VM_ANON) {
+			// 초기화된 anon 페이지의 union은 더 이상 uninit이 아님 (swap slot 정보) -> 내용은 memcpy로 복사
+			if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, NULL))
+				return false;
+			// 복사가 끝날 때까지 자식 frame과 부모 frame 모두 pageout daemon이 가져가지 못하게 pin
 			struct page* newpage = spt_find_page(dst, upage);
-			memcpy(newpage->frame->kva, p->frame->kva, PGSIZE);
+			if (!vm_claim_pinned(newpage))
+				return false;
+			struct frame *pframe = vm_pin_resident_frame(p);
+			// 부모 페이지가 swap out 되어 있으면 부모의 swap slot에서 바로 읽어옴 (slot은 부모가 계속 가짐)
+			bool copied = true;
+			if (pframe == NULL)
+				copied = swap_in(p, newpage->frame->kva);
+			else {
+				memcpy(newpage->frame->kva, pframe->kva, PGSIZE);
+				pframe->pinned = false;
+			}
+			newpage->frame->pinned = false;
+			if (!copied)
+				return false;
 		}
-        else if (type == VM_FILE) {
-            if (!vm_alloc_page_with_initializer(type, upage, writable, init, aux))
+        else if (type == VM_PAGE_CACHE) {
+			// 부모와 같은 cache 페이지를 가리키므로 내용 복사 없이 fault 때 매핑
+			struct container *container = malloc(sizeof *container);
+			if (container == NULL)
 				return false;
-			if (!vm_claim_page(upage))
+			container->file = p->page_cache.file;
+			container->offset = p->page_cache.offset;
+			container->page_read_bytes = PGSIZE;
+            if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, container))
 				return false;
-			struct page* newpage = spt_find_page(dst, upage);
-			memcpy(newpage->frame->kva, p->frame->kva, PGSIZE);
         }
+		spt_find_page(dst, upage)->advice = p->advice;
 	}
 	return true;
 }
@@ -309,17 +915,13 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 void supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
 	/* TODO: Destroy all the supplemental_page_table hold by thread and
 	 * TODO: writeback all the modified contents to the storage. */
-	struct hash_iterator i;
-
-    hash_first (&i, &spt->pages);
-    while (hash_next (&i)) {
-        struct page *page = hash_entry (hash_cur (&i), struct page, hash_elem);
-
-        if (page->operations->type == VM_FILE) {
-            do_munmap(page->va);
-            // destroy(page);
-        }
-    }
+    // 이 프로세스의 페이지를 읽어 오는 중인 prefetch 요청부터 정리
+    advise_cancel(thread_current());
+    // 파일 매핑의 dirty bit를 page cache로 옮긴 뒤 페이지 정리
+    file_backed_unmap_all();
+    // dirty bit를 다 읽었으므로 매핑과 page table을 한 번에 걷어냄.
+    // 이후 페이지별 pml4_clear_page는 비어 있는 pml4에서 바로 끝남
+    vm_clear_range(thread_current()->pml4, NULL, (void *) KERN_BASE);
     hash_destroy(&spt->pages, spt_destructor);
 }
 
@@ -353,7 +955,8 @@ bool delete_page(struct hash *pages, struct page *p) {
 }
 
 void spt_destructor(struct hash_elem *e, void* aux) {
-    const struct page *p = hash_entry(e, struct page, hash_elem);
-    free(p);
+    struct page *p = hash_entry(e, struct page, hash_elem);
+    // destroy에서 frame과 swap slot을 반납
+    vm_dealloc_page(p);
 }
 